@@ -0,0 +1,321 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Arnés de benchmark común a ej1-ej4.
+//  - Cada medición hace `warmup` corridas descartadas y `reps` corridas
+//    medidas con steady_clock; se reportan mediana, p95, media, desvío y mínimo.
+//  - BenchReport junta filas (nombre, tamaño, hilos) y calcula speedup y
+//    eficiencia contra la corrida con menos hilos del mismo nombre y tamaño,
+//    más la fracción serial de Amdahl ajustada por mínimos cuadrados.
+//  - La salida puede ser texto, CSV o JSON.
+//  - BenchArgs lee las opciones comunes de la línea de comandos para que cada
+//    programa corra sin preguntas por cin:
+//      --bench  --warmup N  --reps N  --threads 1,2,4  --sizes a,b,c
+//      --format text|csv|json  --out archivo
+// Benchmark harness shared by ej1-ej4.
+//  - Every measurement runs `warmup` discarded runs and `reps` timed runs with
+//    steady_clock; median, p95, mean, stddev and minimum are reported.
+//  - BenchReport collects rows (name, size, threads) and computes speedup and
+//    efficiency against the lowest thread count with the same name and size,
+//    plus a least-squares Amdahl serial fraction.
+//  - Output can be text, CSV or JSON.
+//  - BenchArgs parses the common command-line options so each program runs
+//    without cin prompts.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct BenchStats {
+    int reps = 0;
+    double median = 0;   // segundos / seconds
+    double p95 = 0;
+    double mean = 0;
+    double stddev = 0;
+    double min = 0;
+};
+
+// Estadísticas de una lista de tiempos (en segundos)
+// Statistics of a list of timings (in seconds)
+inline BenchStats bench_stats(std::vector<double> samples) {
+    BenchStats s;
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    s.reps = (int)n;
+    s.min = samples.front();
+    s.median = (n % 2) ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    // p95 por rango más cercano / nearest-rank p95
+    size_t rank = (size_t)std::ceil(0.95 * (double)n);
+    s.p95 = samples[std::min(n, std::max<size_t>(1, rank)) - 1];
+    double sum = 0;
+    for (double v : samples) sum += v;
+    s.mean = sum / (double)n;
+    double var = 0;
+    for (double v : samples) var += (v - s.mean) * (v - s.mean);
+    s.stddev = n > 1 ? std::sqrt(var / (double)(n - 1)) : 0.0;
+    return s;
+}
+
+// Corre fn() warmup veces sin medir y reps veces midiendo cada una
+// Runs fn() warmup times untimed and reps times timing each one
+template <typename Fn>
+BenchStats bench_measure(int warmup, int reps, Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+    for (int i = 0; i < warmup; i++) fn();
+    std::vector<double> samples;
+    samples.reserve((size_t)std::max(1, reps));
+    for (int i = 0; i < std::max(1, reps); i++) {
+        auto start = clock::now();
+        fn();
+        samples.push_back(std::chrono::duration<double>(clock::now() - start).count());
+    }
+    return bench_stats(std::move(samples));
+}
+
+// Opciones de línea de comandos: "--clave valor", "--bandera" y posicionales.
+// Las banderas de is_flag nunca toman valor, así "ej3 --perf 128" deja 128
+// como posicional.
+// Command-line options: "--key value", "--flag" and positionals.
+// Flags listed in is_flag never take a value, so "ej3 --perf 128" keeps 128
+// as a positional.
+class BenchArgs {
+public:
+    BenchArgs(int argc, char* argv[]) {
+        for (int i = 1; i < argc; i++) {
+            std::string a = argv[i];
+            if (a.size() > 2 && a.compare(0, 2, "--") == 0) {
+                std::string key = a.substr(2);
+                if (!is_flag(key) && i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0)
+                    options[key] = argv[++i];
+                else
+                    options[key] = "";
+            } else {
+                positional.push_back(a);
+            }
+        }
+    }
+
+    // Modos y banderas de ej1-ej4 que no llevan valor
+    // Modes and flags of ej1-ej4 that take no value
+    static bool is_flag(const std::string& key) {
+        static const char* const flags[] = {
+            "bench", "check", "client", "false-sharing", "index", "keep", "ooc", "perf", "serve",
+        };
+        for (const char* f : flags)
+            if (key == f) return true;
+        return false;
+    }
+
+    bool has(const std::string& key) const { return options.count(key) > 0; }
+
+    std::string get(const std::string& key, const std::string& def) const {
+        auto it = options.find(key);
+        return (it == options.end() || it->second.empty()) ? def : it->second;
+    }
+
+    long long get_int(const std::string& key, long long def) const {
+        // Acepta notación científica ("1e8") / accepts scientific notation
+        return has(key) ? (long long)std::strtold(get(key, "0").c_str(), nullptr) : def;
+    }
+
+    long double get_real(const std::string& key, long double def) const {
+        return has(key) ? std::strtold(get(key, "0").c_str(), nullptr) : def;
+    }
+
+    // Lista separada por comas; acepta notación científica
+    // Comma-separated list; accepts scientific notation
+    std::vector<long long> get_list(const std::string& key, const std::vector<long long>& def) const {
+        if (!has(key) || get(key, "").empty()) return def;
+        std::vector<long long> out;
+        std::stringstream ss(get(key, ""));
+        std::string item;
+        while (std::getline(ss, item, ','))
+            if (!item.empty()) out.push_back((long long)std::strtold(item.c_str(), nullptr));
+        return out.empty() ? def : out;
+    }
+
+    int warmup() const { return (int)get_int("warmup", 1); }
+    int reps() const { return (int)get_int("reps", 5); }
+    std::string format() const { return get("format", "text"); }
+
+    // Hilos por defecto: 1, 2, 4, ... hasta hardware_concurrency (incluido)
+    // Default threads: 1, 2, 4, ... up to hardware_concurrency (included)
+    std::vector<long long> threads() const {
+        long long hw = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<long long> def;
+        for (long long t = 1; t < hw; t *= 2) def.push_back(t);
+        def.push_back(hw);
+        return get_list("threads", def);
+    }
+
+    std::vector<std::string> positional;
+
+private:
+    std::map<std::string, std::string> options;
+};
+
+struct BenchRow {
+    std::string name;
+    long long size = 0;
+    int threads = 1;
+    BenchStats stats;
+    double speedup = 1.0;
+    double efficiency = 1.0;
+};
+
+class BenchReport {
+public:
+    explicit BenchReport(std::string title) : title(std::move(title)) {}
+
+    void add(const std::string& name, long long size, int threads, const BenchStats& stats) {
+        BenchRow row;
+        row.name = name;
+        row.size = size;
+        row.threads = threads;
+        row.stats = stats;
+        rows.push_back(row);
+    }
+
+    // Mide fn() con los parámetros de args y agrega la fila
+    // Times fn() with args' parameters and adds the row
+    template <typename Fn>
+    const BenchStats& run(const BenchArgs& args, const std::string& name, long long size,
+                          int threads, Fn&& fn) {
+        add(name, size, threads, bench_measure(args.warmup(), args.reps(), fn));
+        if (args.format() == "text") {
+            std::cerr << "  " << name << " size=" << size << " threads=" << threads
+                      << " mediana=" << rows.back().stats.median << " s\n";
+        }
+        return rows.back().stats;
+    }
+
+    // Escribe el reporte en el formato pedido (a --out si se indicó)
+    // Writes the report in the requested format (to --out if given)
+    void print(const BenchArgs& args) {
+        finalize();
+        std::string path = args.get("out", "");
+        std::ofstream file;
+        if (!path.empty()) file.open(path);
+        std::ostream& os = (path.empty() || !file) ? std::cout : file;
+        std::string fmt = args.format();
+        if (fmt == "csv") print_csv(os);
+        else if (fmt == "json") print_json(os);
+        else print_text(os);
+    }
+
+private:
+    struct Fit {
+        double serial_fraction = 0;
+        double base_time = 0;
+    };
+
+    // Speedup y eficiencia contra la corrida con menos hilos; ajuste de Amdahl
+    // T(p)/T(1) = f + (1 - f)/p  =>  T(p)/T(1) - 1/p = f * (1 - 1/p)
+    // Speedup and efficiency against the lowest thread count; Amdahl fit
+    void finalize() {
+        fits.clear();
+        std::map<std::pair<std::string, long long>, std::vector<BenchRow*>> groups;
+        for (auto& r : rows) groups[{r.name, r.size}].push_back(&r);
+        for (auto& g : groups) {
+            BenchRow* base = g.second.front();
+            for (BenchRow* r : g.second)
+                if (r->threads < base->threads) base = r;
+            double t1 = base->stats.median * base->threads;   // T(1) estimado / estimated
+            double sxy = 0, sxx = 0;
+            for (BenchRow* r : g.second) {
+                r->speedup = r->stats.median > 0 ? base->stats.median / r->stats.median : 0.0;
+                r->efficiency = r->speedup * base->threads / r->threads;
+                if (base->threads == 1 && r->threads > 1 && t1 > 0) {
+                    double p = r->threads;
+                    double x = 1.0 - 1.0 / p;
+                    double y = r->stats.median / t1 - 1.0 / p;
+                    sxy += x * y;
+                    sxx += x * x;
+                }
+            }
+            Fit fit;
+            fit.base_time = base->stats.median;
+            fit.serial_fraction = sxx > 0 ? std::min(1.0, std::max(0.0, sxy / sxx)) : NAN;
+            fits[g.first] = fit;
+        }
+    }
+
+    void print_text(std::ostream& os) const {
+        const std::ios_base::fmtflags saved_flags = os.flags();
+        const std::streamsize saved_precision = os.precision();
+        os << "\n=== BENCHMARK: " << title << " ===\n";
+        os << std::left << std::setw(34) << "nombre" << std::right << std::setw(14) << "tam."
+           << std::setw(7) << "hilos" << std::setw(13) << "mediana(s)" << std::setw(13) << "p95(s)"
+           << std::setw(13) << "desv.(s)" << std::setw(10) << "speedup" << std::setw(10) << "efic." << "\n";
+        for (const auto& r : rows) {
+            os << std::left << std::setw(34) << r.name << std::right << std::setw(14) << r.size
+               << std::setw(7) << r.threads << std::fixed << std::setprecision(6)
+               << std::setw(13) << r.stats.median << std::setw(13) << r.stats.p95
+               << std::setw(13) << r.stats.stddev << std::setprecision(3)
+               << std::setw(10) << r.speedup << std::setw(10) << r.efficiency << "\n";
+        }
+        for (const auto& f : fits) {
+            if (std::isnan(f.second.serial_fraction)) continue;
+            os << "Amdahl " << f.first.first << " (tamaño " << f.first.second << "): fracción serial "
+               << std::setprecision(4) << f.second.serial_fraction;
+            if (f.second.serial_fraction > 0)
+                os << ", speedup máximo " << std::setprecision(2) << 1.0 / f.second.serial_fraction << "x";
+            os << "\n";
+        }
+        os.flags(saved_flags);
+        os.precision(saved_precision);
+    }
+
+    void print_csv(std::ostream& os) const {
+        os << "benchmark,name,size,threads,reps,median_s,p95_s,mean_s,stddev_s,min_s,speedup,efficiency,amdahl_serial_fraction\n";
+        os << std::setprecision(9);
+        for (const auto& r : rows) {
+            double f = fits.at({r.name, r.size}).serial_fraction;
+            os << title << "," << r.name << "," << r.size << "," << r.threads << "," << r.stats.reps << ","
+               << r.stats.median << "," << r.stats.p95 << "," << r.stats.mean << "," << r.stats.stddev << ","
+               << r.stats.min << "," << r.speedup << "," << r.efficiency << ",";
+            if (!std::isnan(f)) os << f;
+            os << "\n";
+        }
+    }
+
+    void print_json(std::ostream& os) const {
+        os << std::setprecision(9);
+        os << "{\"benchmark\":\"" << title << "\",\"rows\":[";
+        for (size_t i = 0; i < rows.size(); i++) {
+            const auto& r = rows[i];
+            os << (i ? "," : "") << "\n  {\"name\":\"" << r.name << "\",\"size\":" << r.size
+               << ",\"threads\":" << r.threads << ",\"reps\":" << r.stats.reps
+               << ",\"median_s\":" << r.stats.median << ",\"p95_s\":" << r.stats.p95
+               << ",\"mean_s\":" << r.stats.mean << ",\"stddev_s\":" << r.stats.stddev
+               << ",\"min_s\":" << r.stats.min << ",\"speedup\":" << r.speedup
+               << ",\"efficiency\":" << r.efficiency << "}";
+        }
+        os << "\n],\"amdahl\":[";
+        bool first = true;
+        for (const auto& f : fits) {
+            if (std::isnan(f.second.serial_fraction)) continue;
+            os << (first ? "" : ",") << "\n  {\"name\":\"" << f.first.first << "\",\"size\":" << f.first.second
+               << ",\"serial_fraction\":" << f.second.serial_fraction << "}";
+            first = false;
+        }
+        os << "\n]}\n";
+    }
+
+    std::string title;
+    std::vector<BenchRow> rows;
+    std::map<std::pair<std::string, long long>, Fit> fits;
+};
+
+#endif
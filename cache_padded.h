@@ -0,0 +1,41 @@
+#ifndef CACHE_PADDED_H
+#define CACHE_PADDED_H
+
+// Ranura de resultado alineada y rellenada a una línea de caché completa.
+// Cuando cada hilo escribe su propio resultado en un vector compartido, los
+// elementos vecinos comparten línea y cada escritura invalida la copia de los
+// demás núcleos (false sharing). Con CachePadded<T> cada elemento ocupa al
+// menos una línea propia, así que un std::vector<CachePadded<T>> se puede
+// usar directamente como arreglo de resultados por hilo o por tarea.
+// Cache-line aligned and padded result slot. When every thread writes its own
+// result into a shared vector, neighbouring elements share a line and each
+// write invalidates the other cores' copy (false sharing). With
+// CachePadded<T> every element owns at least one full line, so a
+// std::vector<CachePadded<T>> works directly as a per-thread or per-task
+// result array.
+
+#include <cstddef>
+
+// Tamaño de línea asumido; se puede redefinir al compilar (-DCACHE_LINE_SIZE=128)
+// Assumed line size; can be overridden at compile time (-DCACHE_LINE_SIZE=128)
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+template <typename T>
+struct alignas(CACHE_LINE_SIZE) CachePadded {
+    T value{};
+
+    CachePadded() = default;
+    CachePadded(const T& v) : value(v) {}
+
+    T& operator*() { return value; }
+    const T& operator*() const { return value; }
+    T* operator->() { return &value; }
+    const T* operator->() const { return &value; }
+};
+
+static_assert(sizeof(CachePadded<char>) == CACHE_LINE_SIZE,
+              "CachePadded debe ocupar una línea completa");
+
+#endif
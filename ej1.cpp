@@ -1,66 +1,416 @@
 #include <iostream>
 #include <cmath>
 #include <thread>
+#include <atomic>
+#include <algorithm>
 #include <vector>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#include "bench.h"
+#include "cache_padded.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
 
 using namespace std;
 
-// Función que calcula una parte de la serie de Taylor
-void calcular_parcial(long double y, long long inicio, long long fin, long double &resultado) {
-    long double suma = 0.0;
+// Los términos se agrupan en bloques de tamaño fijo, independientes de la
+// cantidad de hilos. Cada bloque se suma siempre igual y los parciales se
+// combinan en orden de bloque, así el resultado es idéntico bit a bit para
+// cualquier num_hilos (y entre la versión secuencial y la paralela).
+const long long TERMINOS_POR_BLOQUE = 1 << 16;
+
+// Suma compensada de Neumaier: c acumula el error de redondeo de cada suma
+struct SumaCompensada {
+    long double suma = 0.0L;
+    long double c = 0.0L;
+
+    void agregar(long double v) {
+        long double t = suma + v;
+        if (fabsl(suma) >= fabsl(v)) c += (suma - t) + v;
+        else c += (v - t) + suma;
+        suma = t;
+    }
+    long double valor() const { return suma + c; }
+};
+
+// Un parcial por bloque, cada uno en su propia línea de caché
+using ParcialesBloque = vector<CachePadded<SumaCompensada>>;
+
+// Suma los términos y^n / n con n = 2k+1 para k en [inicio, fin).
+// y^(2*inicio+1) se calcula una sola vez y luego se multiplica por y^2.
+SumaCompensada serie_bloque(long double y, long long inicio, long long fin) {
+    SumaCompensada s;
+    long double y2 = y * y;
+    long double potencia = powl(y, 2 * inicio + 1);
     for (long long k = inicio; k < fin; k++) {
         long long n = 2 * k + 1; // índices impares
-        long double termino = pow(y, n) / n;
-        suma += termino;
+        s.agregar(potencia / n);
+        potencia *= y2;
     }
-    resultado = suma;
+    return s;
+}
+
+// Función que calcula una parte de la serie de Taylor: los bloques
+// [bloque_inicio, bloque_fin) se guardan en parciales[b]
+void calcular_parcial(long double y, long long bloque_inicio, long long bloque_fin,
+                      long long terminos, ParcialesBloque &parciales) {
+    for (long long b = bloque_inicio; b < bloque_fin; b++) {
+        long long inicio = b * TERMINOS_POR_BLOQUE;
+        long long fin = min(terminos, inicio + TERMINOS_POR_BLOQUE);
+        *parciales[b] = serie_bloque(y, inicio, fin);
+    }
+}
+
+// Combina los parciales en orden de bloque (orden fijo de reducción)
+long double reducir_parciales(const ParcialesBloque &parciales) {
+    SumaCompensada total;
+    for (const auto &p : parciales) {
+        total.agregar(p->suma);
+        total.agregar(p->c);
+    }
+    return total.valor();
+}
+
+long long cantidad_bloques(long long terminos) {
+    return (terminos + TERMINOS_POR_BLOQUE - 1) / TERMINOS_POR_BLOQUE;
 }
 
 // Versión secuencial
 long double ln_secuencial(long double x, long long terminos) {
     long double y = (x - 1) / (x + 1);
-    long double suma = 0.0;
-    for (long long k = 0; k < terminos; k++) {
-        long long n = 2 * k + 1;
-        suma += pow(y, n) / n;
-    }
-    return 2.0 * suma;
+    long long bloques = cantidad_bloques(terminos);
+    ParcialesBloque parciales(bloques);
+    calcular_parcial(y, 0, bloques, terminos, parciales);
+    return 2.0 * reducir_parciales(parciales);
 }
 
 // Versión paralela
 long double ln_paralelo(long double x, long long terminos, int num_hilos) {
     long double y = (x - 1) / (x + 1);
+    long long bloques = cantidad_bloques(terminos);
 
-    vector<thread> hilos;
-    vector<long double> resultados(num_hilos, 0.0);
+    ParcialesBloque parciales(bloques);
 
-    long long bloque = terminos / num_hilos;
+    // Un trozo de bloques por tarea en el pool compartido
+    WorkStealingPool &pool = WorkStealingPool::shared(num_hilos);
+    parallel_for(pool, 0LL, bloques, 1LL, [&](long long inicio, long long fin) {
+        PerfScope region("ej1/serie");
+        calcular_parcial(y, inicio, fin, terminos, parciales);
+    });
 
-    for (int i = 0; i < num_hilos; i++) {
-        long long inicio = i * bloque;
-        long long fin = (i == num_hilos - 1) ? terminos : (i + 1) * bloque;
-        hilos.push_back(thread(calcular_parcial, y, inicio, fin, ref(resultados[i])));
+    return 2.0 * reducir_parciales(parciales);
+}
+
+// Versión con corte por tolerancia: en lugar de una cantidad fija de términos,
+// los hilos toman bloques de un cursor atómico compartido (como next_segment en
+// ej4) y se detienen cuando la cola de la serie ya no puede mover el resultado
+// más que la tolerancia relativa. Como los términos decrecen, después del
+// término k la cola es <= y^(2k+1) / ((2k+1)(1 - y^2)), y atanh(y) >= y sirve
+// de cota inferior del resultado. El primer bloque que cumple la cota es
+// siempre el mismo, así que el resultado sigue siendo idéntico bit a bit para
+// cualquier num_hilos. terminos_max acota el trabajo cuando x es muy grande.
+struct ResultadoTolerancia {
+    long double valor = 0.0L;
+    long long terminos_usados = 0;     // términos que entran en el resultado
+    long long terminos_calculados = 0; // incluye bloques descartados por otros hilos
+    bool convergio = false;
+};
+
+ResultadoTolerancia ln_paralelo_tolerancia(long double x, long double tolerancia,
+                                           long long terminos_max, int num_hilos) {
+    long double y = (x - 1) / (x + 1);
+    long double y2 = y * y;
+    long long bloques = cantidad_bloques(terminos_max);
+
+    ParcialesBloque parciales(bloques);
+    atomic<long long> cursor(0);
+    atomic<long long> fin_bloques(bloques);   // primer bloque que ya no hace falta
+    atomic<long long> calculados(0);
+
+    auto trabajador = [&]() {
+        for (;;) {
+            long long b = cursor.fetch_add(1, memory_order_relaxed);
+            if (b >= fin_bloques.load(memory_order_relaxed)) break;
+
+            long long inicio = b * TERMINOS_POR_BLOQUE;
+            long long fin = min(terminos_max, inicio + TERMINOS_POR_BLOQUE);
+            *parciales[b] = serie_bloque(y, inicio, fin);
+            calculados.fetch_add(fin - inicio, memory_order_relaxed);
+
+            long long n = 2 * fin + 1;
+            // Para 0 < x < 1, y es negativo: se acota con |y|^n o una n impar
+            // daría una cota negativa y cortaría en el primer bloque
+            long double cola = powl(fabsl(y), n) / (n * (1.0L - y2));
+            if (cola <= tolerancia * fabsl(y)) {
+                long long actual = fin_bloques.load(memory_order_relaxed);
+                while (b + 1 < actual &&
+                       !fin_bloques.compare_exchange_weak(actual, b + 1, memory_order_relaxed)) {
+                }
+                break;
+            }
+        }
+    };
+
+    WorkStealingPool::shared(num_hilos).run(num_hilos, [&](int) { trabajador(); });
+
+    ResultadoTolerancia r;
+    long long usados = fin_bloques.load();
+    parciales.resize(usados);
+    r.valor = 2.0 * reducir_parciales(parciales);
+    r.terminos_usados = min(terminos_max, usados * TERMINOS_POR_BLOQUE);
+    r.terminos_calculados = calculados.load();
+    r.convergio = usados < bloques ||
+                  powl(fabsl(y), 2 * terminos_max + 1) / ((2 * terminos_max + 1) * (1.0L - y2)) <= tolerancia * fabsl(y);
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// ln por lotes con reducción de rango
+// x = m * 2^e con m en [sqrt(2)/2, sqrt(2)), entonces ln(x) = e*ln(2) + ln(m).
+// Con y = (m-1)/(m+1) se cumple |y| <= 0.1716, y^2 <= 0.0295, y la serie de
+// atanh converge a precisión double en LN_TERMINOS términos (en lugar de 10^7).
+// La cantidad de términos es fija y el cuerpo no tiene ramas ni llamadas, así
+// el compilador puede vectorizar el bucle entre elementos (compilar con
+// -O3 -march=native para que use AVX2).
+// ---------------------------------------------------------------------------
+const int LN_TERMINOS = 12;
+const double LN2_HI = 6.93147180369123816490e-01;  // ln(2) con los bits bajos en cero
+const double LN2_LO = 1.90821492927058770002e-10;  // ln(2) - LN2_HI
+
+// Evalúa ln sobre [inicio, fin). La reducción solo vale para x normales,
+// finitos y > 0; el resto se corrige con std::log en una segunda pasada
+// sobre el mismo trozo, que todavía está en caché.
+void ln_lote_rango(const double* __restrict entrada, double* __restrict salida,
+                   size_t inicio, size_t fin) {
+    const uint64_t MASCARA_EXP = 0x7ff0000000000000ULL;
+    const uint64_t EXP_UNO = 0x3ff0000000000000ULL;
+    for (size_t i = inicio; i < fin; i++) {
+        uint64_t bits;
+        memcpy(&bits, &entrada[i], sizeof bits);
+        double e = (double)((int64_t)((bits & MASCARA_EXP) >> 52) - 1023);
+        bits = (bits & ~MASCARA_EXP) | EXP_UNO;   // m en [1, 2)
+        double m;
+        memcpy(&m, &bits, sizeof m);
+
+        bool grande = m > 1.4142135623730951;       // llevar m a [sqrt(2)/2, sqrt(2))
+        m = grande ? m * 0.5 : m;
+        e = grande ? e + 1.0 : e;
+
+        double y = (m - 1.0) / (m + 1.0);
+        double y2 = y * y;
+        double p = 1.0 / (2 * (LN_TERMINOS - 1) + 1);
+        for (int k = LN_TERMINOS - 2; k >= 0; k--) {
+            p = p * y2 + 1.0 / (2 * k + 1);       // Horner en y^2
+        }
+        salida[i] = e * LN2_HI + (e * LN2_LO + 2.0 * y * p);
+    }
+
+    // Casos fuera del dominio de la reducción: 0, negativos, subnormales, inf, NaN
+    for (size_t i = inicio; i < fin; i++) {
+        double v = entrada[i];
+        if (!(v >= 2.2250738585072014e-308 && v <= 1.7976931348623157e308)) {
+            salida[i] = log(v);
+        }
+    }
+}
+
+// ln de cada elemento de entrada, repartido en trozos contiguos en el pool
+void ln_lote(const vector<double>& entrada, vector<double>& salida, int num_hilos) {
+    size_t n = entrada.size();
+    salida.resize(n);
+    if (num_hilos < 1) num_hilos = 1;
+
+    WorkStealingPool &pool = WorkStealingPool::shared(num_hilos);
+    parallel_for(pool, (size_t)0, n, (size_t)4096, [&](size_t inicio, size_t fin) {
+        PerfScope region("ej1/ln_lote");
+        ln_lote_rango(entrada.data(), salida.data(), inicio, fin);
+    });
+}
+
+// Compara ln_lote contra std::log y mide valores por segundo
+void benchmark_ln_lote(long double x, int num_hilos) {
+    const size_t cantidad = 10000000;
+    vector<double> entrada(cantidad), salida(cantidad), referencia(cantidad);
+
+    // Valores log-uniformes en [1e-6, 1e12], más el x ingresado
+    mt19937_64 gen(12345);
+    uniform_real_distribution<double> exponente(-6.0, 12.0);
+    for (auto &v : entrada) v = pow(10.0, exponente(gen));
+    entrada[0] = (double)x;
+
+    auto inicio0 = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < cantidad; i++) referencia[i] = log(entrada[i]);
+    auto fin0 = chrono::high_resolution_clock::now();
+    chrono::duration<double> tiempo_std = fin0 - inicio0;
+
+    // El pool compartido se crea (o cambia de tamaño) antes de cada
+    // medición, así no se cuenta el arranque de los hilos
+    WorkStealingPool::shared(1);
+    auto inicio1 = chrono::high_resolution_clock::now();
+    ln_lote(entrada, salida, 1);
+    auto fin1 = chrono::high_resolution_clock::now();
+    chrono::duration<double> tiempo_seq = fin1 - inicio1;
+
+    WorkStealingPool::shared(num_hilos);
+    auto inicio2 = chrono::high_resolution_clock::now();
+    ln_lote(entrada, salida, num_hilos);
+    auto fin2 = chrono::high_resolution_clock::now();
+    chrono::duration<double> tiempo_par = fin2 - inicio2;
+
+    double error_max = 0.0;
+    for (size_t i = 0; i < cantidad; i++) {
+        double ref = referencia[i];
+        double err = (ref != 0.0) ? fabs((salida[i] - ref) / ref) : fabs(salida[i]);
+        if (err > error_max) error_max = err;
     }
 
+    cout << "\n[Lote con reduccion de rango] " << cantidad << " valores" << endl;
+    cout << "ln(" << x << ") = " << salida[0] << endl;
+    cout << "Error relativo maximo vs std::log: " << error_max << endl;
+    cout << "std::log:           " << cantidad / tiempo_std.count() / 1e6 << " Mvalores/s" << endl;
+    cout << "Lote (1 hilo):      " << cantidad / tiempo_seq.count() / 1e6 << " Mvalores/s" << endl;
+    cout << "Lote (" << num_hilos << " hilos):    " << cantidad / tiempo_par.count() / 1e6 << " Mvalores/s" << endl;
+}
+
+// ---------------------------------------------------------------------------
+// Microbenchmark de false sharing: cada hilo incrementa su propia ranura
+// muchas veces, con las ranuras contiguas (vector<atomic>) o rellenadas a
+// línea de caché (vector<CachePadded<atomic>>). Se usan load/store relajados
+// para que el compilador no guarde el contador en un registro.
+// ---------------------------------------------------------------------------
+template <typename Ranura>
+double medir_ranuras(int num_hilos, long long incrementos) {
+    vector<Ranura> ranuras(num_hilos);
+    vector<thread> hilos;
+
+    auto inicio = chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_hilos; i++) {
+        hilos.push_back(thread([&ranuras, i, incrementos]() {
+            atomic<long long> &r = *ranuras[i];
+            for (long long k = 0; k < incrementos; k++) {
+                r.store(r.load(memory_order_relaxed) + 1, memory_order_relaxed);
+            }
+        }));
+    }
     for (auto &h : hilos) {
         h.join();
     }
+    auto fin = chrono::high_resolution_clock::now();
+    return chrono::duration<double>(fin - inicio).count();
+}
+
+// atomic<long long> sin relleno, con la misma interfaz que CachePadded
+struct RanuraContigua {
+    atomic<long long> value{0};
+    atomic<long long> &operator*() { return value; }
+};
+
+void benchmark_false_sharing() {
+    const long long incrementos = 20000000;
+    cout << "\n[False sharing] " << incrementos << " incrementos por hilo" << endl;
+    cout << "hilos | contiguo (s) | rellenado (s) | mejora" << endl;
+    for (int num_hilos : {1, 8, 32, 64}) {
+        double contiguo = medir_ranuras<RanuraContigua>(num_hilos, incrementos);
+        double rellenado = medir_ranuras<CachePadded<atomic<long long>>>(num_hilos, incrementos);
+        cout << num_hilos << " | " << contiguo << " | " << rellenado << " | "
+             << contiguo / rellenado << "x" << endl;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Trabajos chicos repetidos: la misma serie corta calculada muchas veces,
+// creando hilos en cada llamada o usando el pool persistente compartido.
+// ---------------------------------------------------------------------------
+void benchmark_trabajos_chicos(int num_hilos) {
+    const int repeticiones = 2000;
+    const long long terminos = 1 << 14;
+    const long double y = 0.999999L;
+    vector<SumaCompensada> parciales(num_hilos);
+
+    auto inicio1 = chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeticiones; r++) {
+        vector<thread> hilos;
+        for (int i = 0; i < num_hilos; i++) {
+            hilos.push_back(thread([&parciales, i, num_hilos, y, terminos]() {
+                parciales[i] = serie_bloque(y, terminos * i / num_hilos, terminos * (i + 1) / num_hilos);
+            }));
+        }
+        for (auto &h : hilos) {
+            h.join();
+        }
+    }
+    auto fin1 = chrono::high_resolution_clock::now();
+    chrono::duration<double> tiempo_hilos = fin1 - inicio1;
 
-    long double suma_total = 0.0;
-    for (auto r : resultados) suma_total += r;
+    WorkStealingPool &pool = WorkStealingPool::shared(num_hilos);
+    auto inicio2 = chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeticiones; r++) {
+        pool.run(num_hilos, [&parciales, num_hilos, y, terminos](int i) {
+            parciales[i] = serie_bloque(y, terminos * i / num_hilos, terminos * (i + 1) / num_hilos);
+        });
+    }
+    auto fin2 = chrono::high_resolution_clock::now();
+    chrono::duration<double> tiempo_pool = fin2 - inicio2;
 
-    return 2.0 * suma_total;
+    cout << "\n[Trabajos chicos] " << repeticiones << " x " << terminos << " terminos, "
+         << num_hilos << " hilos" << endl;
+    cout << "Hilos nuevos por llamada: " << tiempo_hilos.count() / repeticiones * 1e6 << " us/trabajo" << endl;
+    cout << "Pool persistente:         " << tiempo_pool.count() / repeticiones * 1e6 << " us/trabajo" << endl;
+    cout << "Mejora: " << tiempo_hilos.count() / tiempo_pool.count() << "x" << endl;
 }
 
-int main() {
+// Barrido de hilos y cantidad de términos con el arnés común (--bench)
+int correr_benchmark(const BenchArgs &args) {
+    long double x = args.get_real("x", 1.5e6L);
+    BenchReport reporte("ej1");
+    for (long long terminos : args.get_list("sizes", {10000000LL})) {
+        for (long long hilos : args.threads()) {
+            reporte.run(args, "ln_paralelo", terminos, (int)hilos, [&]() {
+                volatile long double r = ln_paralelo(x, terminos, (int)hilos);
+                (void)r;
+            });
+        }
+    }
+    reporte.print(args);
+    if (perf_regions_enabled()) perf_regions_report(cout);
+    return 0;
+}
+
+// Uso:
+//   ej1                                  pregunta x y la cantidad de hilos
+//   ej1 --x 1.5e6 --threads 8            sin preguntas
+//   ej1 ... --tol 1e-12                  tolerancia relativa del corte por tolerancia (1e-10 por defecto)
+//   ej1 --bench [--x 1.5e6] [--sizes 1e6,1e7] [--threads 1,2,4] [--reps 5] [--format csv|json]
+//   ej1 --false-sharing                  ranuras contiguas vs rellenadas a línea de caché
+//   --perf agrega contadores de hardware por región
+int main(int argc, char *argv[]) {
+    BenchArgs args(argc, argv);
+    if (args.has("perf")) perf_regions_enable();
+    if (args.has("bench")) return correr_benchmark(args);
+    if (args.has("false-sharing")) {
+        benchmark_false_sharing();
+        return 0;
+    }
+
     long double x;
     int num_hilos;
 
-    cout << "Ingrese el valor de x (>1.5e6): ";
-    cin >> x;
-    cout << "Ingrese el numero de hilos: ";
-    cin >> num_hilos;
+    if (args.has("x")) {
+        x = args.get_real("x", 0);
+    } else {
+        cout << "Ingrese el valor de x (>1.5e6): ";
+        cin >> x;
+    }
+    if (args.has("threads")) {
+        num_hilos = (int)args.get_int("threads", 1);
+    } else {
+        cout << "Ingrese el numero de hilos: ";
+        cin >> num_hilos;
+    }
+    if (num_hilos < 1) num_hilos = 1;
 
     const long long terminos = 10000000;
 
@@ -85,6 +435,40 @@ int main() {
 
     // Speedup
     cout << "\nSpeedup = " << tiempo1.count() / tiempo2.count() << endl;
+    cout << "Terminos/s secuencial: " << terminos / tiempo1.count() << endl;
+    cout << "Terminos/s paralelo:   " << terminos / tiempo2.count() << endl;
+    cout << "Resultados identicos bit a bit: " << (res1 == res2 ? "si" : "no") << endl;
+
+    // Contadores de hardware de la serie paralela (--perf); se reinician
+    // después para que el resto de las mediciones no se mezcle
+    if (perf_regions_enabled()) {
+        perf_regions_report(cout);
+        perf_regions_reset();
+    }
+
+    // Corte por tolerancia relativa
+    const long double tolerancia = args.get_real("tol", 1e-10L);
+    auto inicio3 = chrono::high_resolution_clock::now();
+    ResultadoTolerancia res3 = ln_paralelo_tolerancia(x, tolerancia, 10 * terminos, num_hilos);
+    auto fin3 = chrono::high_resolution_clock::now();
+    chrono::duration<double> tiempo3 = fin3 - inicio3;
+
+    cout << "\n[Tolerancia " << (double)tolerancia << "] ln(" << x << ") = " << res3.valor << endl;
+    cout << "Terminos usados: " << res3.terminos_usados
+         << " (calculados: " << res3.terminos_calculados << ", fijo: " << terminos << ")" << endl;
+    if (!res3.convergio) {
+        cout << "ADVERTENCIA: no alcanzo la tolerancia con " << 10 * terminos << " terminos" << endl;
+    }
+    cout << "Tiempo: " << tiempo3.count() << " segundos (ahorro vs paralelo fijo: "
+         << tiempo2.count() - tiempo3.count() << " segundos)" << endl;
+
+    // Lote de valores con reducción de rango
+    benchmark_ln_lote(x, num_hilos);
+
+    // Costo de crear hilos frente al pool persistente
+    benchmark_trabajos_chicos(num_hilos);
+
+    if (perf_regions_enabled()) perf_regions_report(cout);
 
     return 0;
 }
@@ -7,20 +7,705 @@
 #include <chrono>
 #include <mutex>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include "bench.h"
+#include "cache_padded.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PATTERN_SEARCH_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PATTERN_SEARCH_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PATTERN_SEARCH_HAS_SOCKETS 1
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+// Autómata Aho-Corasick para contar todos los patrones en una sola pasada.
+// Los bytes se agrupan en clases (una por byte presente en los patrones más
+// una clase "otro"), de modo que la tabla de transiciones es una matriz plana
+// estados x clases, pequeña y contigua en memoria. Con los 256 bytes en uso
+// hay 257 clases, por eso los identificadores son de 16 bits.
+class AhoCorasick {
+private:
+    std::array<uint16_t, 256> byte_class{};
+    size_t num_classes = 1;
+    std::vector<uint32_t> delta;        // delta[estado * num_classes + clase]
+    std::vector<uint32_t> fail;         // enlace de fallo de cada estado
+    std::vector<uint32_t> bfs_order;    // estados en orden de profundidad creciente
+    std::vector<uint8_t> has_output;    // 1 si algún patrón termina en el estado o en su cadena de fallos
+    std::vector<uint32_t> terminal;     // estado final de cada patrón
+    size_t max_length = 0;
+
+    static constexpr uint32_t NO_STATE = UINT32_MAX;
+
+public:
+    explicit AhoCorasick(const std::vector<std::string>& patterns) {
+        // Clases de bytes: 0 = byte que no aparece en ningún patrón
+        for (const auto& pattern : patterns) {
+            for (unsigned char c : pattern) {
+                if (byte_class[c] == 0) {
+                    byte_class[c] = static_cast<uint16_t>(num_classes++);
+                }
+            }
+        }
+
+        // Trie: el estado 0 es la raíz; una transición 0 significa "sin hijo"
+        delta.assign(num_classes, 0);
+        terminal.assign(patterns.size(), NO_STATE);
+        std::vector<uint8_t> is_terminal(1, 0);
+        for (size_t p = 0; p < patterns.size(); p++) {
+            const std::string& pattern = patterns[p];
+            if (pattern.empty()) continue;
+            max_length = std::max(max_length, pattern.length());
+
+            uint32_t state = 0;
+            for (unsigned char c : pattern) {
+                uint32_t& next = delta[state * num_classes + byte_class[c]];
+                if (next == 0) {
+                    next = static_cast<uint32_t>(is_terminal.size());
+                    is_terminal.push_back(0);
+                    delta.resize(delta.size() + num_classes, 0);
+                }
+                state = delta[state * num_classes + byte_class[c]];
+            }
+            is_terminal[state] = 1;
+            terminal[p] = state;
+        }
+
+        // Enlaces de fallo por BFS; las transiciones faltantes se completan
+        // para que el recorrido sea una sola búsqueda en tabla por byte
+        const size_t num_states = is_terminal.size();
+        fail.assign(num_states, 0);
+        has_output.assign(num_states, 0);
+        bfs_order.reserve(num_states);
+
+        std::queue<uint32_t> queue;
+        queue.push(0);
+        while (!queue.empty()) {
+            uint32_t state = queue.front();
+            queue.pop();
+            bfs_order.push_back(state);
+            has_output[state] = is_terminal[state] | has_output[fail[state]];
+
+            for (size_t c = 0; c < num_classes; c++) {
+                uint32_t& next = delta[state * num_classes + c];
+                uint32_t fallback = (state == 0) ? 0 : delta[fail[state] * num_classes + c];
+                if (next != 0) {
+                    fail[next] = fallback;
+                    queue.push(next);
+                } else {
+                    next = fallback;
+                }
+            }
+        }
+    }
+
+    size_t state_count() const { return fail.size(); }
+    size_t max_pattern_length() const { return max_length; }
+
+    // Avanza el autómata sobre [data, data + len) sin contar coincidencias
+    uint32_t advance(const char* data, size_t len, uint32_t state) const {
+        const uint32_t* d = delta.data();
+        const size_t classes = num_classes;
+        for (size_t i = 0; i < len; i++) {
+            state = d[state * classes + byte_class[static_cast<unsigned char>(data[i])]];
+        }
+        return state;
+    }
+
+    // Avanza el autómata acumulando visitas a estados con salida
+    uint32_t scan(const char* data, size_t len, uint32_t state, std::vector<uint64_t>& visits) const {
+        const uint32_t* d = delta.data();
+        const uint8_t* out = has_output.data();
+        uint64_t* v = visits.data();
+        const size_t classes = num_classes;
+        for (size_t i = 0; i < len; i++) {
+            state = d[state * classes + byte_class[static_cast<unsigned char>(data[i])]];
+            if (out[state]) {
+                v[state]++;
+            }
+        }
+        return state;
+    }
+
+    // Convierte visitas por estado en ocurrencias (solapadas) por patrón:
+    // cada visita a un estado cuenta también para toda su cadena de fallos
+    std::vector<size_t> counts_from_visits(std::vector<uint64_t> visits) const {
+        for (size_t i = bfs_order.size(); i-- > 1;) {
+            uint32_t state = bfs_order[i];
+            visits[fail[state]] += visits[state];
+        }
+        std::vector<size_t> counts(terminal.size(), 0);
+        for (size_t p = 0; p < terminal.size(); p++) {
+            if (terminal[p] != NO_STATE) {
+                counts[p] = static_cast<size_t>(visits[terminal[p]]);
+            }
+        }
+        return counts;
+    }
+};
+
+// Búsqueda vectorizada con prefiltro de primer y último byte: se comparan a
+// la vez 16/32 posiciones candidatas contra el primer y el último byte del
+// patrón y solo las posiciones que coinciden en ambos se verifican con memcmp.
+// Cuenta ocurrencias solapadas, igual que KMP.
+namespace simd_search {
+
+// Versión escalar (usada en el resto final y cuando no hay SIMD)
+inline size_t count_scalar(const char* text, size_t n, const char* pattern, size_t m, size_t from = 0) {
+    if (m == 0 || n < m) return 0;
+    size_t count = 0;
+    const char first = pattern[0];
+    const char last = pattern[m - 1];
+    for (size_t i = from; i + m <= n; i++) {
+        if (text[i] == first && text[i + m - 1] == last &&
+            std::memcmp(text + i + 1, pattern + 1, m > 2 ? m - 2 : 0) == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+#ifdef PATTERN_SEARCH_HAS_X86_SIMD
+__attribute__((target("sse2")))
+inline size_t count_sse2(const char* text, size_t n, const char* pattern, size_t m) {
+    if (m == 0 || n < m) return 0;
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[m - 1]);
+    const size_t middle = m > 2 ? m - 2 : 0;
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+        while (mask != 0) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (std::memcmp(text + i + bit + 1, pattern + 1, middle) == 0) {
+                count++;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return count + count_scalar(text, n, pattern, m, i);
+}
+
+__attribute__((target("avx2")))
+inline size_t count_avx2(const char* text, size_t n, const char* pattern, size_t m) {
+    if (m == 0 || n < m) return 0;
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[m - 1]);
+    const size_t middle = m > 2 ? m - 2 : 0;
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last))));
+        while (mask != 0) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (std::memcmp(text + i + bit + 1, pattern + 1, middle) == 0) {
+                count++;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return count + count_scalar(text, n, pattern, m, i);
+}
+#endif
+
+using CountFunction = size_t (*)(const char*, size_t, const char*, size_t);
+
+inline size_t count_scalar_entry(const char* text, size_t n, const char* pattern, size_t m) {
+    return count_scalar(text, n, pattern, m);
+}
+
+// Elige la mejor implementación según las capacidades de la CPU (una sola vez)
+inline CountFunction select_kernel(const char** name = nullptr) {
+    static const std::pair<CountFunction, const char*> selected = []() {
+#ifdef PATTERN_SEARCH_HAS_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return std::make_pair<CountFunction, const char*>(count_avx2, "AVX2");
+        if (__builtin_cpu_supports("sse2")) return std::make_pair<CountFunction, const char*>(count_sse2, "SSE2");
+#endif
+        return std::make_pair<CountFunction, const char*>(count_scalar_entry, "escalar");
+    }();
+    if (name != nullptr) {
+        *name = selected.second;
+    }
+    return selected.first;
+}
+
+} // namespace simd_search
+
+// Arreglo de sufijos del texto: cuenta un patrón con dos búsquedas binarias,
+// en O(m log n), sin recorrer el texto. Se construye por duplicación de
+// prefijos (al estilo Larsson-Sadakane): los sufijos se reparten en baldes
+// por sus 2 primeros bytes, cada balde se ordena por los 8 primeros y
+// después, en cada ronda, solo los grupos que siguen empatados se reordenan
+// por el rango del sufijo que empieza k posiciones más adelante, duplicando
+// k. Los grupos de una ronda son independientes y se reparten en el pool
+// compartido; los muy grandes (texto repetitivo) se ordenan con
+// parallel_sort. Se guarda en disco con una cabecera que identifica el
+// texto y en corridas siguientes se proyecta con mmap.
+class SuffixArrayIndex {
+public:
+    SuffixArrayIndex() = default;
+    
+    ~SuffixArrayIndex() {
+        release();
+    }
+    
+    SuffixArrayIndex(const SuffixArrayIndex&) = delete;
+    SuffixArrayIndex& operator=(const SuffixArrayIndex&) = delete;
+    
+    // Construye el arreglo de sufijos con num_threads participantes del pool
+    // compartido. Las posiciones son de 32 bits: el texto debe medir < 4 GB.
+    static std::vector<uint32_t> build(std::string_view text, size_t num_threads) {
+        const size_t n = text.size();
+        if (n >= UINT32_MAX) {
+            throw std::runtime_error("texto demasiado grande para un arreglo de sufijos de 32 bits");
+        }
+        WorkStealingPool& pool = WorkStealingPool::shared((int)std::max<size_t>(1, num_threads));
+        const unsigned char* t = reinterpret_cast<const unsigned char*>(text.data());
+        
+        std::vector<uint32_t> sa(n);
+        std::vector<uint32_t> rank(n);
+        std::vector<uint8_t> starts(n);
+        std::vector<Group> groups = bucket_by_first_two_bytes(pool, t, n, sa, rank);
+        
+        // Primeros 8 bytes en orden big-endian (ceros al pasar el final: el
+        // empate con un sufijo más largo se resuelve en la primera ronda)
+        auto prefix = [t, n](uint32_t i) {
+            uint64_t key = 0;
+            const size_t len = std::min<size_t>(8, n - i);
+            for (size_t j = 0; j < len; j++) {
+                key |= (uint64_t)t[i + j] << (56 - 8 * j);
+            }
+            return key;
+        };
+        
+        groups = refine(pool, groups, prefix, sa, rank, starts);
+        
+        // Un sufijo que termina antes de i + k es prefijo de los demás de su
+        // grupo y va primero (clave por debajo de BEYOND); entre dos así, el
+        // más corto primero
+        for (size_t k = 8; !groups.empty(); k *= 2) {
+            auto shifted = [&rank, n, k](uint32_t i) -> uint64_t {
+                return i + k < n ? BEYOND + rank[i + k] : BEYOND - 1 - (i + k - n);
+            };
+            groups = refine(pool, groups, shifted, sa, rank, starts);
+        }
+        return sa;
+    }
+    
+    // Hash FNV-1a de una muestra fija del texto (SAMPLE_BLOCKS bloques de
+    // SAMPLE_BYTES repartidos parejo desde el principio, más el final), para no
+    // usar un índice de otra versión del archivo. Recorrer el texto entero en
+    // cada apertura costaría O(n) antes de consultas O(m log n); junto con el
+    // tamaño exacto, la muestra detecta cualquier regeneración del archivo.
+    static uint64_t text_hash(std::string_view text) {
+        uint64_t hash = 1469598103934665603ULL;
+        auto mix = [&hash](std::string_view part) {
+            for (unsigned char c : part) {
+                hash = (hash ^ c) * 1099511628211ULL;
+            }
+        };
+        const size_t n = text.size();
+        if (n <= SAMPLE_BLOCKS * SAMPLE_BYTES) {
+            mix(text);
+            return hash;
+        }
+        for (size_t b = 0; b < SAMPLE_BLOCKS; b++) {
+            mix(text.substr((n - SAMPLE_BYTES) / (SAMPLE_BLOCKS - 1) * b, SAMPLE_BYTES));
+        }
+        mix(text.substr(n - SAMPLE_BYTES));
+        return hash;
+    }
+    
+    // Guarda cabecera + posiciones en path
+    bool save(const std::string& path, std::string_view text, uint64_t hash) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Error: No se pudo crear el archivo " << path << std::endl;
+            return false;
+        }
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof header.magic);
+        header.text_size = text.size();
+        header.text_hash = hash;
+        file.write(reinterpret_cast<const char*>(&header), sizeof header);
+        file.write(reinterpret_cast<const char*>(entries), static_cast<std::streamsize>(length * sizeof(uint32_t)));
+        return static_cast<bool>(file);
+    }
+    
+    // Abre un índice guardado; falla (sin tocar el índice actual) si no
+    // existe o si fue construido para otro texto (tamaño o hash distintos)
+    bool open(const std::string& path, std::string_view text, uint64_t hash) {
+        Header header{};
+        const size_t expected = sizeof header + text.size() * sizeof(uint32_t);
+#ifdef PATTERN_SEARCH_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != expected) {
+            close(fd);
+            return false;
+        }
+        void* data = mmap(nullptr, expected, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        std::memcpy(&header, data, sizeof header);
+        if (!matches(header, text, hash)) {
+            munmap(data, expected);
+            return false;
+        }
+        // Las búsquedas binarias saltan por todo el arreglo
+        madvise(data, expected, MADV_RANDOM);
+        release();
+        mapped_data = data;
+        mapped_size = expected;
+        entries = reinterpret_cast<const uint32_t*>(static_cast<const char*>(data) + sizeof header);
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof header) ||
+            !matches(header, text, hash)) {
+            return false;
+        }
+        std::vector<uint32_t> loaded(text.size());
+        file.read(reinterpret_cast<char*>(loaded.data()), static_cast<std::streamsize>(loaded.size() * sizeof(uint32_t)));
+        if (!file) {
+            return false;
+        }
+        adopt(std::move(loaded));
+#endif
+        length = text.size();
+        return true;
+    }
+    
+    // Usa un arreglo recién construido sin pasar por disco
+    void adopt(std::vector<uint32_t> sa) {
+        release();
+        storage = std::move(sa);
+        entries = storage.data();
+        length = storage.size();
+    }
+    
+    // Cantidad de apariciones (con solapamiento) de pattern en text, que debe
+    // ser el mismo texto sobre el que se construyó el índice
+    size_t count(std::string_view text, std::string_view pattern) const {
+        if (pattern.empty() || length == 0) {
+            return 0;
+        }
+        // Compara el sufijo en pos con el patrón, mirando solo m bytes
+        auto compare = [&](uint32_t pos) {
+            const size_t len = std::min(pattern.size(), text.size() - pos);
+            int c = std::memcmp(text.data() + pos, pattern.data(), len);
+            if (c != 0) return c;
+            return len < pattern.size() ? -1 : 0;
+        };
+        const uint32_t* end = entries + length;
+        const uint32_t* lower = std::partition_point(entries, end, [&](uint32_t pos) { return compare(pos) < 0; });
+        const uint32_t* upper = std::partition_point(lower, end, [&](uint32_t pos) { return compare(pos) <= 0; });
+        return static_cast<size_t>(upper - lower);
+    }
+    
+    bool is_mapped() const { return mapped_data != nullptr; }
+    
+    // Bytes del índice en disco (cabecera + 4 bytes por posición)
+    size_t index_bytes() const { return sizeof(Header) + length * sizeof(uint32_t); }
+    
+private:
+    using Group = std::pair<uint32_t, uint32_t>;   // [inicio, fin) dentro de sa
+    
+    struct Header {
+        char magic[8];
+        uint64_t text_size;
+        uint64_t text_hash;
+    };
+    static constexpr const char* MAGIC = "EJ2SA02";
+    static constexpr size_t SAMPLE_BLOCKS = 256;   // bloques que entran en text_hash
+    static constexpr size_t SAMPLE_BYTES = 4096;
+    static constexpr uint64_t BEYOND = uint64_t(1) << 40;
+    
+    using Keyed = std::pair<uint64_t, uint32_t>;   // (clave, posición)
+    
+    // Radix LSD por bytes; se saltan los bytes iguales en todas las claves
+    // (en un balde los 2 primeros bytes ya coinciden)
+    static void sort_keyed(std::vector<Keyed>& keyed, std::vector<Keyed>& buffer) {
+        if (keyed.size() < 256) {
+            std::sort(keyed.begin(), keyed.end());
+            return;
+        }
+        size_t counts[8][256] = {};
+        for (const Keyed& e : keyed) {
+            for (int d = 0; d < 8; d++) counts[d][(e.first >> (8 * d)) & 255]++;
+        }
+        buffer.resize(keyed.size());
+        for (int d = 0; d < 8; d++) {
+            if (counts[d][(keyed[0].first >> (8 * d)) & 255] == keyed.size()) continue;
+            size_t offset = 0;
+            for (size_t& c : counts[d]) {
+                size_t count = c;
+                c = offset;
+                offset += count;
+            }
+            for (const Keyed& e : keyed) buffer[counts[d][(e.first >> (8 * d)) & 255]++] = e;
+            keyed.swap(buffer);
+        }
+    }
+    
+    static bool matches(const Header& header, std::string_view text, uint64_t hash) {
+        return std::memcmp(header.magic, MAGIC, sizeof header.magic) == 0 &&
+               header.text_size == text.size() && header.text_hash == hash;
+    }
+    
+    // Ordenamiento por conteo de los sufijos según sus 2 primeros bytes, en
+    // paralelo (histograma por trozo y reparto estable). Deja en rank el
+    // inicio del balde de cada sufijo y devuelve los baldes con más de uno.
+    static std::vector<Group> bucket_by_first_two_bytes(WorkStealingPool& pool, const unsigned char* t, size_t n,
+                                                        std::vector<uint32_t>& sa, std::vector<uint32_t>& rank) {
+        const size_t buckets = size_t(1) << 16;
+        auto first_two = [t, n](size_t i) {
+            return ((size_t)t[i] << 8) | (i + 1 < n ? t[i + 1] : 0);
+        };
+        const size_t parts = std::max<size_t>(1, std::min<size_t>((size_t)pool.size(), n >> 16));
+        std::vector<std::vector<uint32_t>> offsets(parts, std::vector<uint32_t>(buckets, 0));
+        pool.run((int)parts, [&](int p) {
+            for (size_t i = n * p / parts; i < n * (p + 1) / parts; i++) offsets[p][first_two(i)]++;
+        });
+        
+        std::vector<Group> groups;
+        std::vector<uint32_t> bucket_start(buckets);
+        uint32_t next = 0;
+        for (size_t b = 0; b < buckets; b++) {
+            bucket_start[b] = next;
+            for (size_t p = 0; p < parts; p++) {
+                uint32_t count = offsets[p][b];
+                offsets[p][b] = next;
+                next += count;
+            }
+            if (next - bucket_start[b] > 1) groups.push_back({bucket_start[b], next});
+        }
+        
+        pool.run((int)parts, [&](int p) {
+            for (size_t i = n * p / parts; i < n * (p + 1) / parts; i++) {
+                const size_t b = first_two(i);
+                sa[offsets[p][b]++] = (uint32_t)i;
+                rank[i] = bucket_start[b];
+            }
+        });
+        return groups;
+    }
+    
+    // Una ronda: ordena cada grupo por key, marca dónde cambia la clave y
+    // recién después (cuando ninguna tarea lee más rank) reasigna los rangos.
+    // El rango de un sufijo es la posición en sa donde empieza su grupo.
+    // Devuelve los subgrupos que siguen empatados, en orden.
+    template <typename Key>
+    static std::vector<Group> refine(WorkStealingPool& pool, const std::vector<Group>& groups, Key key,
+                                     std::vector<uint32_t>& sa, std::vector<uint32_t>& rank,
+                                     std::vector<uint8_t>& starts) {
+        const size_t big = std::max<size_t>(size_t(1) << 16, sa.size() / (4 * (size_t)pool.size()));
+        auto by_key = [&key](uint32_t a, uint32_t b) { return key(a) < key(b); };
+        auto mark = [&](size_t group_begin, size_t lo, size_t hi) {
+            for (size_t j = lo; j < hi; j++) {
+                starts[j] = j == group_begin || key(sa[j]) != key(sa[j - 1]);
+            }
+        };
+        
+        // Los grupos grandes usan todo el pool cada uno; los chicos, uno por tarea
+        std::vector<Group> small;
+        for (const Group& g : groups) {
+            if (g.second - g.first < big) {
+                small.push_back(g);
+                continue;
+            }
+            parallel_sort(pool, sa.begin() + g.first, sa.begin() + g.second, by_key);
+            parallel_for(pool, (size_t)g.first, (size_t)g.second, size_t(1) << 16, [&](size_t lo, size_t hi) {
+                mark(g.first, lo, hi);
+            });
+        }
+        // Cada clave se calcula una sola vez (un acceso aleatorio por sufijo,
+        // no uno por comparación) y se ordenan pares (clave, posición) por radix
+        parallel_for(pool, size_t(0), small.size(), size_t(64), [&](size_t lo, size_t hi) {
+            std::vector<Keyed> keyed;
+            std::vector<Keyed> buffer;
+            for (size_t s = lo; s < hi; s++) {
+                const uint32_t l = small[s].first;
+                const uint32_t r = small[s].second;
+                keyed.clear();
+                for (uint32_t j = l; j < r; j++) {
+                    keyed.emplace_back(key(sa[j]), sa[j]);
+                }
+                sort_keyed(keyed, buffer);
+                for (uint32_t j = l; j < r; j++) {
+                    sa[j] = keyed[j - l].second;
+                    starts[j] = j == l || keyed[j - l].first != keyed[j - l - 1].first;
+                }
+            }
+        });
+        
+        return parallel_reduce(pool, size_t(0), groups.size(), size_t(64), std::vector<Group>(),
+            [&](size_t lo, size_t hi) {
+                std::vector<Group> pending;
+                for (size_t g = lo; g < hi; g++) {
+                    uint32_t start = groups[g].first;
+                    for (uint32_t j = groups[g].first; j < groups[g].second; j++) {
+                        if (starts[j]) {
+                            if (j - start > 1) pending.push_back({start, j});
+                            start = j;
+                        }
+                        rank[sa[j]] = start;
+                    }
+                    if (groups[g].second - start > 1) pending.push_back({start, groups[g].second});
+                }
+                return pending;
+            },
+            [](std::vector<Group> all, const std::vector<Group>& part) {
+                all.insert(all.end(), part.begin(), part.end());
+                return all;
+            });
+    }
+    
+    void release() {
+#ifdef PATTERN_SEARCH_HAS_MMAP
+        if (mapped_data != nullptr) {
+            munmap(mapped_data, mapped_size);
+        }
+#endif
+        mapped_data = nullptr;
+        mapped_size = 0;
+        storage.clear();
+        entries = nullptr;
+        length = 0;
+    }
+    
+    const uint32_t* entries = nullptr;
+    size_t length = 0;
+    std::vector<uint32_t> storage;
+    void* mapped_data = nullptr;
+    size_t mapped_size = 0;
+};
+
+// Forma de cargar el texto en memoria
+enum class TextLoader {
+    Mmap,      // proyección de solo lectura del archivo (sin copia)
+    Ifstream,  // lectura completa a un std::string (alternativa portable)
+    None       // no cargar el texto (modo streaming para archivos más grandes que la RAM)
+};
 
 class PatternSearcher {
 private:
-    std::string text;
+    // Todas las búsquedas trabajan sobre esta vista; apunta a la proyección
+    // mmap o a text_storage según el cargador utilizado
+    std::string_view text;
+    std::string text_storage;
+    void* mapped_data = nullptr;
+    size_t mapped_size = 0;
     std::vector<std::string> patterns;
+    SuffixArrayIndex suffix_index;
     std::mutex output_mutex;
     
 public:
     // Constructor - carga los archivos
-    PatternSearcher() {
-        load_text_file("texto_ej2.txt");
+    explicit PatternSearcher(TextLoader loader = TextLoader::Mmap) {
+        {
+            PerfScope scope("ej2/load");
+            if (loader == TextLoader::Ifstream || (loader == TextLoader::Mmap && !load_text_file_mmap("texto_ej2.txt"))) {
+                load_text_file("texto_ej2.txt");
+            }
+        }
         load_patterns_file("patrones.txt");
     }
     
+    ~PatternSearcher() {
+        release_mapping();
+    }
+    
+    PatternSearcher(const PatternSearcher&) = delete;
+    PatternSearcher& operator=(const PatternSearcher&) = delete;
+    
+    // Proyectar el archivo de texto en memoria (solo lectura, sin copia)
+    bool load_text_file_mmap(const std::string& filename) {
+#ifdef PATTERN_SEARCH_HAS_MMAP
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: No se pudo abrir el archivo " << filename << std::endl;
+            return false;
+        }
+        
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        
+        size_t file_size = static_cast<size_t>(st.st_size);
+        std::cout << "Proyectando archivo de texto (" << file_size / (1024 * 1024) << " MB) con mmap..." << std::endl;
+        
+        void* data = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            std::cerr << "Aviso: mmap falló, se usa la lectura con ifstream" << std::endl;
+            return false;
+        }
+        
+        // Lectura secuencial: el kernel puede adelantar páginas agresivamente
+        madvise(data, file_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+        madvise(data, file_size, MADV_HUGEPAGE);
+#endif
+        
+        release_mapping();
+        text_storage.clear();
+        mapped_data = data;
+        mapped_size = file_size;
+        text = std::string_view(static_cast<const char*>(data), file_size);
+        
+        std::cout << "Archivo proyectado exitosamente. Tamaño: " << text.length() << " caracteres" << std::endl;
+        return true;
+#else
+        (void)filename;
+        return false;
+#endif
+    }
+    
     // Cargar archivo de texto (200MB)
     bool load_text_file(const std::string& filename) {
         std::ifstream file(filename, std::ios::binary);
@@ -38,8 +723,11 @@ public:
         std::cout << "Cargando archivo de texto (" << file_size / (1024 * 1024) << " MB)..." << std::endl;
         
         // Reservar memoria y leer todo el archivo
-        text.reserve(file_size);
-        text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        release_mapping();
+        text_storage.assign(file_size, '\0');
+        file.read(&text_storage[0], static_cast<std::streamsize>(file_size));
+        text_storage.resize(static_cast<size_t>(file.gcount()));
+        text = text_storage;
         
         file.close();
         
@@ -92,6 +780,7 @@ public:
         if (pattern.empty() || text.empty()) {
             return 0;
         }
+        PerfScope scope("ej2/search_kmp");
         
         // Construir tabla de fallos para KMP
         std::vector<int> failure_table(pattern.length(), 0);
@@ -120,7 +809,173 @@ public:
         return count;
     }
     
+    // Versión vectorizada (AVX2/SSE2/escalar según la CPU)
+    size_t count_pattern_occurrences_simd(const std::string& pattern) const {
+        if (pattern.empty() || text.empty()) {
+            return 0;
+        }
+        PerfScope scope("ej2/search_simd");
+        return simd_search::select_kernel()(text.data(), text.length(), pattern.data(), pattern.length());
+    }
+    
+    // Búsqueda multipatrón: un único recorrido del texto con Aho-Corasick
+    std::vector<size_t> count_patterns_aho_corasick() const {
+        AhoCorasick automaton(patterns);
+        std::vector<uint64_t> visits(automaton.state_count(), 0);
+        PerfScope scope("ej2/search_aho");
+        automaton.scan(text.data(), text.length(), 0, visits);
+        return automaton.counts_from_visits(std::move(visits));
+    }
+    
+    // Búsqueda particionando el texto (no los patrones) entre hilos.
+    // Cada hilo cuenta las coincidencias que terminan dentro de su trozo;
+    // antes de contar recorre los (longitud máxima - 1) bytes previos para
+    // que el autómata llegue al borde con el mismo estado que en la pasada
+    // secuencial. Así ninguna coincidencia se pierde ni se cuenta dos veces,
+    // y el paralelismo no depende de la cantidad de patrones.
+    std::vector<size_t> count_patterns_text_partitioned(size_t num_threads) const {
+        return count_patterns_text_partitioned(patterns, num_threads);
+    }
+    
+    // Igual, para un conjunto de patrones cualquiera (modo servidor)
+    std::vector<size_t> count_patterns_text_partitioned(const std::vector<std::string>& pattern_set,
+                                                        size_t num_threads) const {
+        AhoCorasick automaton(pattern_set);
+        const size_t n = text.length();
+        const size_t overlap = automaton.max_pattern_length() > 0 ? automaton.max_pattern_length() - 1 : 0;
+        num_threads = std::max<size_t>(1, std::min(num_threads, n > 0 ? n : 1));
+        const size_t chunk = (n + num_threads - 1) / num_threads;
+        
+        std::vector<std::vector<uint64_t>> visits(num_threads, std::vector<uint64_t>(automaton.state_count(), 0));
+        
+        WorkStealingPool::shared((int)num_threads).run((int)num_threads, [&](int t) {
+            size_t begin = std::min(n, (size_t)t * chunk);
+            size_t end = std::min(n, begin + chunk);
+            size_t warmup = std::min(begin, overlap);
+            PerfScope scope("ej2/search_partitioned");
+            uint32_t state = automaton.advance(text.data() + begin - warmup, warmup, 0);
+            automaton.scan(text.data() + begin, end - begin, state, visits[t]);
+        });
+        
+        for (size_t t = 1; t < num_threads; t++) {
+            for (size_t s = 0; s < visits[0].size(); s++) {
+                visits[0][s] += visits[t][s];
+            }
+        }
+        return automaton.counts_from_visits(std::move(visits[0]));
+    }
+    
+    // Búsqueda en streaming: lee el archivo en bloques de tamaño fijo con doble
+    // buffer (un hilo lector llena un bloque mientras se busca en el otro) y
+    // arrastra el estado del autómata entre bloques, por lo que los conteos
+    // coinciden con la búsqueda en memoria. La memoria usada es 2 * block_size
+    // más el autómata, sin importar el tamaño del archivo.
+    std::vector<size_t> count_patterns_streaming(const std::string& filename, size_t block_size,
+                                                 size_t* bytes_processed = nullptr) const {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: No se pudo abrir el archivo " << filename << std::endl;
+            return std::vector<size_t>(patterns.size(), 0);
+        }
+        
+        struct Block {
+            std::vector<char> data;
+            size_t size = 0;
+            bool full = false;
+        };
+        
+        block_size = std::max<size_t>(1, block_size);
+        Block blocks[2];
+        blocks[0].data.resize(block_size);
+        blocks[1].data.resize(block_size);
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool end_of_file = false;
+        
+        // Hilo lector: alterna entre los dos bloques
+        std::thread reader([&]() {
+            size_t index = 0;
+            while (true) {
+                Block& block = blocks[index];
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return !block.full; });
+                }
+                
+                file.read(block.data.data(), static_cast<std::streamsize>(block_size));
+                size_t got = static_cast<size_t>(file.gcount());
+                
+                std::lock_guard<std::mutex> lock(mutex);
+                if (got == 0) {
+                    end_of_file = true;
+                    changed.notify_all();
+                    return;
+                }
+                block.size = got;
+                block.full = true;
+                changed.notify_all();
+                index ^= 1;
+            }
+        });
+        
+        AhoCorasick automaton(patterns);
+        std::vector<uint64_t> visits(automaton.state_count(), 0);
+        uint32_t state = 0;
+        size_t total = 0;
+        size_t index = 0;
+        
+        while (true) {
+            Block& block = blocks[index];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return block.full || end_of_file; });
+                if (!block.full) {
+                    break;
+                }
+            }
+            
+            state = automaton.scan(block.data.data(), block.size, state, visits);
+            total += block.size;
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            block.full = false;
+            changed.notify_all();
+            index ^= 1;
+        }
+        
+        reader.join();
+        
+        if (bytes_processed != nullptr) {
+            *bytes_processed = total;
+        }
+        return automaton.counts_from_visits(std::move(visits));
+    }
+    
 private:
+    void release_mapping() {
+#ifdef PATTERN_SEARCH_HAS_MMAP
+        if (mapped_data != nullptr) {
+            munmap(mapped_data, mapped_size);
+        }
+#endif
+        mapped_data = nullptr;
+        mapped_size = 0;
+        text = std::string_view();
+    }
+    
+#ifdef PATTERN_SEARCH_HAS_MMAP
+    // Pico de memoria residente del proceso en KB
+    static long peak_rss_kb() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;  // macOS informa bytes
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    
     // Construir tabla de fallos para algoritmo KMP
     void build_failure_table(const std::string& pattern, std::vector<int>& table) const {
         int j = 0;
@@ -148,15 +1003,15 @@ public:
         }
         
         auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+        auto duration = std::chrono::duration<double, std::milli>(end_time - start_time);
         
         std::cout << "\nTiempo de ejecución secuencial: " << duration.count() << " ms" << std::endl;
     }
     
     // Función que ejecutará cada hilo
-    void search_pattern_thread(size_t pattern_index, std::vector<size_t>& results) {
+    void search_pattern_thread(size_t pattern_index, std::vector<CachePadded<size_t>>& results) {
         if (pattern_index < patterns.size()) {
-            results[pattern_index] = count_pattern_occurrences_kmp(patterns[pattern_index]);
+            *results[pattern_index] = count_pattern_occurrences_kmp(patterns[pattern_index]);
         }
     }
     
@@ -166,32 +1021,52 @@ public:
         
         auto start_time = std::chrono::high_resolution_clock::now();
         
-        std::vector<std::thread> threads;
-        std::vector<size_t> results(patterns.size(), 0);
+        std::vector<CachePadded<size_t>> results(patterns.size());
         
-        // Crear 32 hilos (uno por patrón, asumiendo que hay 32 patrones)
-        for (size_t i = 0; i < patterns.size() && i < 32; i++) {
-            threads.emplace_back([this, i, &results]() {
-                search_pattern_thread(i, results);
-            });
-        }
-        
-        // Esperar a que todos los hilos terminen
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        // 32 hilos del pool compartido, una tarea por patrón
+        WorkStealingPool& pool = WorkStealingPool::shared(32);
+        pool.run((int)patterns.size(), [this, &results](int i) {
+            search_pattern_thread((size_t)i, results);
+        });
         
         auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+        auto duration = std::chrono::duration<double, std::milli>(end_time - start_time);
         
         // Mostrar resultados
         for (size_t i = 0; i < patterns.size(); i++) {
-            std::cout << "el patron " << i << " aparece " << results[i] << " veces" << std::endl;
+            std::cout << "el patron " << i << " aparece " << *results[i] << " veces" << std::endl;
         }
         
         std::cout << "\nTiempo de ejecución con hilos: " << duration.count() << " ms" << std::endl;
     }
     
+    // Conteo KMP de todos los patrones en el pool compartido, una tarea por patrón
+    std::vector<size_t> count_patterns_kmp_pool(size_t num_threads) const {
+        std::vector<CachePadded<size_t>> results(patterns.size());
+        
+        // El robo de trabajo reparte los patrones más lentos
+        WorkStealingPool& pool = WorkStealingPool::shared((int)std::max<size_t>(1, num_threads));
+        pool.run((int)patterns.size(), [this, &results](int p) {
+            *results[p] = count_pattern_occurrences_kmp(patterns[p]);
+        });
+        
+        std::vector<size_t> counts(patterns.size());
+        for (size_t i = 0; i < patterns.size(); i++) counts[i] = *results[i];
+        return counts;
+    }
+    
+    // Bytes cargados del archivo de texto
+    size_t loaded_size() const {
+        return mapped_data != nullptr ? mapped_size : text_storage.size();
+    }
+    
+    // Limita las búsquedas a los primeros bytes del texto cargado (para
+    // barridos de tamaño); limit_text(loaded_size()) vuelve al texto completo
+    void limit_text(size_t bytes) {
+        const char* base = mapped_data != nullptr ? static_cast<const char*>(mapped_data) : text_storage.data();
+        text = std::string_view(base, std::min(bytes, loaded_size()));
+    }
+    
     // Implementación con pool de hilos más eficiente
     void search_patterns_thread_pool() {
         std::cout << "\n=== BÚSQUEDA CON POOL DE HILOS ===" << std::endl;
@@ -199,34 +1074,207 @@ public:
         auto start_time = std::chrono::high_resolution_clock::now();
         
         const size_t num_threads = std::min(static_cast<size_t>(32), patterns.size());
-        std::vector<std::thread> threads;
-        std::vector<size_t> results(patterns.size(), 0);
-        std::atomic<size_t> pattern_index{0};
-        
-        // Crear hilos que trabajen en un pool
-        for (size_t i = 0; i < num_threads; i++) {
-            threads.emplace_back([this, &results, &pattern_index]() {
-                size_t current_pattern;
-                while ((current_pattern = pattern_index.fetch_add(1)) < patterns.size()) {
-                    results[current_pattern] = count_pattern_occurrences_kmp(patterns[current_pattern]);
-                }
-            });
+        std::vector<size_t> results = count_patterns_kmp_pool(num_threads);
+        
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration<double, std::milli>(end_time - start_time);
+        
+        // Mostrar resultados
+        for (size_t i = 0; i < patterns.size(); i++) {
+            std::cout << "el patron " << i << " aparece " << results[i] << " veces" << std::endl;
         }
         
-        // Esperar a que todos los hilos terminen
-        for (auto& thread : threads) {
-            thread.join();
+        std::cout << "\nTiempo de ejecución con pool de hilos: " << duration.count() << " ms" << std::endl;
+    }
+    
+    // Implementación secuencial con el kernel vectorizado, con rendimiento por patrón
+    void search_patterns_simd() {
+        const char* kernel_name = nullptr;
+        simd_search::select_kernel(&kernel_name);
+        std::cout << "\n=== BÚSQUEDA VECTORIZADA (" << kernel_name << ") ===" << std::endl;
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        
+        for (size_t i = 0; i < patterns.size(); i++) {
+            auto start_pattern = std::chrono::high_resolution_clock::now();
+            size_t count = count_pattern_occurrences_simd(patterns[i]);
+            auto end_pattern = std::chrono::high_resolution_clock::now();
+            double seconds = std::chrono::duration<double>(end_pattern - start_pattern).count();
+            
+            std::cout << "el patron " << i << " aparece " << count << " veces";
+            if (seconds > 0) {
+                std::cout << " (" << text.length() / seconds / 1e9 << " GB/s)";
+            }
+            std::cout << std::endl;
         }
         
         auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+        auto duration = std::chrono::duration<double, std::milli>(end_time - start_time);
+        
+        std::cout << "\nTiempo de ejecución vectorizado: " << duration.count() << " ms" << std::endl;
+    }
+    
+    // Implementación particionando el texto en trozos por hilo
+    void search_patterns_text_partitioned(size_t num_threads) {
+        std::cout << "\n=== BÚSQUEDA PARTICIONANDO EL TEXTO (" << num_threads << " HILOS) ===" << std::endl;
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        std::vector<size_t> results = count_patterns_text_partitioned(num_threads);
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration<double, std::milli>(end_time - start_time);
         
         // Mostrar resultados
         for (size_t i = 0; i < patterns.size(); i++) {
             std::cout << "el patron " << i << " aparece " << results[i] << " veces" << std::endl;
         }
         
-        std::cout << "\nTiempo de ejecución con pool de hilos: " << duration.count() << " ms" << std::endl;
+        std::cout << "\nTiempo de ejecución particionando el texto: " << duration.count() << " ms" << std::endl;
+    }
+    
+    // Implementación en streaming (no requiere tener el texto en memoria)
+    void search_patterns_streaming(const std::string& filename, size_t block_size) {
+        std::cout << "\n=== BÚSQUEDA EN STREAMING (bloques de " << block_size / 1024 << " KB) ===" << std::endl;
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        size_t bytes = 0;
+        std::vector<size_t> results = count_patterns_streaming(filename, block_size, &bytes);
+        auto end_time = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        
+        // Si el texto también está en memoria, verificar contra la pasada completa
+        std::vector<size_t> in_memory;
+        if (!text.empty()) {
+            in_memory = count_patterns_aho_corasick();
+        }
+        
+        for (size_t i = 0; i < patterns.size(); i++) {
+            std::cout << "el patron " << i << " aparece " << results[i] << " veces";
+            if (!in_memory.empty() && in_memory[i] != results[i]) {
+                std::cout << "  <-- DIFERENCIA (en memoria: " << in_memory[i] << ")";
+            }
+            std::cout << std::endl;
+        }
+        
+        std::cout << "\nTiempo de ejecución en streaming: " << ms << " ms" << std::endl;
+        if (ms > 0) {
+            std::cout << "Rendimiento: " << (bytes / (1024.0 * 1024.0)) / (ms / 1000.0) << " MB/s" << std::endl;
+        }
+        std::cout << "Memoria de buffers: " << 2 * block_size / 1024 << " KB" << std::endl;
+    }
+    
+    // Abre el índice de sufijos guardado en index_path o, si no existe o es
+    // de otro texto, lo construye con num_threads hilos y lo guarda
+    bool prepare_suffix_index(const std::string& index_path, size_t num_threads, double* build_ms = nullptr) {
+        const uint64_t hash = SuffixArrayIndex::text_hash(text);
+        if (build_ms != nullptr) {
+            *build_ms = 0;
+        }
+        if (suffix_index.open(index_path, text, hash)) {
+            return true;
+        }
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        build_suffix_index(num_threads);
+        auto end_time = std::chrono::high_resolution_clock::now();
+        if (build_ms != nullptr) {
+            *build_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        }
+        
+        // Se guarda y se vuelve a abrir proyectado; si no se puede escribir
+        // queda el arreglo en memoria
+        if (suffix_index.save(index_path, text, hash)) {
+            suffix_index.open(index_path, text, hash);
+        }
+        return false;
+    }
+    
+    // Construye el índice de sufijos del texto actual solo en memoria
+    void build_suffix_index(size_t num_threads) {
+        PerfScope scope("ej2/suffix_build");
+        suffix_index.adopt(SuffixArrayIndex::build(text, num_threads));
+    }
+    
+    // Conteo de todos los patrones con el índice de sufijos ya preparado
+    std::vector<size_t> count_patterns_suffix_array() const {
+        PerfScope scope("ej2/search_suffix");
+        std::vector<size_t> counts(patterns.size());
+        for (size_t i = 0; i < patterns.size(); i++) {
+            counts[i] = suffix_index.count(text, patterns[i]);
+        }
+        return counts;
+    }
+    
+    // Conteo de un conjunto de patrones con el índice, repartido en el pool
+    std::vector<size_t> count_patterns_suffix_array(const std::vector<std::string>& pattern_set,
+                                                    size_t num_threads) const {
+        std::vector<CachePadded<size_t>> results(pattern_set.size());
+        WorkStealingPool& pool = WorkStealingPool::shared((int)std::max<size_t>(1, num_threads));
+        pool.run((int)pattern_set.size(), [&](int p) {
+            PerfScope scope("ej2/search_suffix");
+            *results[p] = suffix_index.count(text, pattern_set[p]);
+        });
+        
+        std::vector<size_t> counts(pattern_set.size());
+        for (size_t i = 0; i < pattern_set.size(); i++) counts[i] = *results[i];
+        return counts;
+    }
+    
+    // Modo índice: construye (o proyecta) el arreglo de sufijos y compara la
+    // latencia por consulta contra el recorrido KMP del texto
+    void search_patterns_suffix_array(const std::string& index_path, size_t num_threads) {
+        std::cout << "\n=== BÚSQUEDA CON ÍNDICE DE SUFIJOS ===" << std::endl;
+        
+        double build_ms = 0;
+        if (prepare_suffix_index(index_path, num_threads, &build_ms)) {
+            std::cout << "Índice proyectado desde " << index_path << " (sin reconstruir)" << std::endl;
+        } else {
+            std::cout << "Índice construido con " << num_threads << " hilos en " << build_ms << " ms";
+            std::cout << (suffix_index.is_mapped() ? ", guardado en " + index_path : ", solo en memoria") << std::endl;
+        }
+        const size_t bytes = suffix_index.index_bytes();
+        std::cout << "Tamaño del índice: " << bytes / (1024 * 1024) << " MB ("
+                  << (text.empty() ? 0.0 : (double)bytes / (double)text.length()) << " bytes por carácter)" << std::endl;
+        
+        double index_us = 0;
+        double kmp_us = 0;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < patterns.size(); i++) {
+            auto start_index = std::chrono::high_resolution_clock::now();
+            size_t count = suffix_index.count(text, patterns[i]);
+            auto end_index = std::chrono::high_resolution_clock::now();
+            size_t kmp_count = count_pattern_occurrences_kmp(patterns[i]);
+            auto end_kmp = std::chrono::high_resolution_clock::now();
+            
+            double query_us = std::chrono::duration<double, std::micro>(end_index - start_index).count();
+            double scan_us = std::chrono::duration<double, std::micro>(end_kmp - end_index).count();
+            index_us += query_us;
+            kmp_us += scan_us;
+            
+            std::cout << "el patron " << i << " aparece " << count << " veces (índice: " << query_us
+                      << " us, KMP: " << scan_us / 1000.0 << " ms)";
+            if (count != kmp_count) {
+                std::cout << "  <-- DIFERENCIA (KMP: " << kmp_count << ")";
+                mismatches++;
+            }
+            std::cout << std::endl;
+        }
+        if (mismatches > 0) {
+            std::cerr << "ADVERTENCIA: " << mismatches << " patrones con conteos distintos entre índice y KMP" << std::endl;
+        }
+        
+        if (!patterns.empty()) {
+            const double per_index = index_us / patterns.size();
+            const double per_kmp = kmp_us / patterns.size();
+            std::cout << "\nLatencia media por consulta: índice " << per_index << " us, KMP "
+                      << per_kmp / 1000.0 << " ms" << std::endl;
+            if (per_index > 0) {
+                std::cout << "Speedup índice vs KMP: " << per_kmp / per_index << "x" << std::endl;
+            }
+            if (build_ms > 0 && per_kmp > per_index) {
+                std::cout << "La construcción se amortiza tras "
+                          << (size_t)(build_ms * 1000.0 / (per_kmp - per_index)) + 1 << " consultas" << std::endl;
+            }
+        }
     }
     
     // Función para calcular y mostrar el speedup
@@ -240,38 +1288,56 @@ public:
             sequential_results[i] = count_pattern_occurrences_kmp(patterns[i]);
         }
         auto end_sequential = std::chrono::high_resolution_clock::now();
-        auto sequential_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_sequential - start_sequential);
+        auto sequential_duration = std::chrono::duration<double, std::milli>(end_sequential - start_sequential);
         
         // Medir tiempo con hilos
         auto start_threaded = std::chrono::high_resolution_clock::now();
         const size_t num_threads = std::min(static_cast<size_t>(32), patterns.size());
-        std::vector<std::thread> threads;
-        std::vector<size_t> threaded_results(patterns.size(), 0);
-        std::atomic<size_t> pattern_index{0};
-        
-        for (size_t i = 0; i < num_threads; i++) {
-            threads.emplace_back([this, &threaded_results, &pattern_index]() {
-                size_t current_pattern;
-                while ((current_pattern = pattern_index.fetch_add(1)) < patterns.size()) {
-                    threaded_results[current_pattern] = count_pattern_occurrences_kmp(patterns[current_pattern]);
-                }
-            });
-        }
+        std::vector<size_t> threaded_results = count_patterns_kmp_pool(num_threads);
+        auto end_threaded = std::chrono::high_resolution_clock::now();
+        auto threaded_duration = std::chrono::duration<double, std::milli>(end_threaded - start_threaded);
+        
+        // Medir tiempo con Aho-Corasick (una sola pasada para todos los patrones)
+        auto start_aho = std::chrono::high_resolution_clock::now();
+        std::vector<size_t> aho_results = count_patterns_aho_corasick();
+        auto end_aho = std::chrono::high_resolution_clock::now();
+        auto aho_duration = std::chrono::duration<double, std::milli>(end_aho - start_aho);
+        
+        // Medir tiempo particionando el texto entre todos los núcleos
+        const size_t partition_threads = std::max(1u, std::thread::hardware_concurrency());
+        auto start_partitioned = std::chrono::high_resolution_clock::now();
+        std::vector<size_t> partitioned_results = count_patterns_text_partitioned(partition_threads);
+        auto end_partitioned = std::chrono::high_resolution_clock::now();
+        auto partitioned_duration = std::chrono::duration<double, std::milli>(end_partitioned - start_partitioned);
         
-        for (auto& thread : threads) {
-            thread.join();
+        // Medir tiempo con el kernel vectorizado (un patrón a la vez)
+        auto start_simd = std::chrono::high_resolution_clock::now();
+        std::vector<size_t> simd_results(patterns.size());
+        for (size_t i = 0; i < patterns.size(); i++) {
+            simd_results[i] = count_pattern_occurrences_simd(patterns[i]);
         }
-        auto end_threaded = std::chrono::high_resolution_clock::now();
-        auto threaded_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_threaded - start_threaded);
+        auto end_simd = std::chrono::high_resolution_clock::now();
+        auto simd_duration = std::chrono::duration<double, std::milli>(end_simd - start_simd);
         
         // Mostrar resultados
-        std::cout << "Resultados:" << std::endl;
+        std::cout << "Resultados (KMP | Aho-Corasick | texto particionado | SIMD):" << std::endl;
+        size_t mismatches = 0;
         for (size_t i = 0; i < patterns.size(); i++) {
-            std::cout << "el patron " << i << " aparece " << sequential_results[i] << " veces" << std::endl;
+            std::cout << "el patron " << i << " aparece " << sequential_results[i] << " veces"
+                      << " | " << aho_results[i] << " | " << partitioned_results[i] << " | " << simd_results[i];
+            if (aho_results[i] != sequential_results[i] || partitioned_results[i] != sequential_results[i] ||
+                simd_results[i] != sequential_results[i]) {
+                std::cout << "  <-- DIFERENCIA";
+                mismatches++;
+            }
+            std::cout << std::endl;
+        }
+        if (mismatches > 0) {
+            std::cerr << "ADVERTENCIA: " << mismatches << " patrones con conteos distintos entre los métodos" << std::endl;
         }
         
         // Calcular speedup
-        double speedup = static_cast<double>(sequential_duration.count()) / threaded_duration.count();
+        double speedup = threaded_duration.count() > 0 ? sequential_duration.count() / threaded_duration.count() : 0.0;
         double efficiency = speedup / num_threads;
         
         std::cout << "\n=== MÉTRICAS DE RENDIMIENTO ===" << std::endl;
@@ -279,6 +1345,22 @@ public:
         std::cout << "Tiempo con " << num_threads << " hilos: " << threaded_duration.count() << " ms" << std::endl;
         std::cout << "Speedup: " << speedup << "x" << std::endl;
         std::cout << "Eficiencia: " << (efficiency * 100) << "%" << std::endl;
+        std::cout << "Tiempo Aho-Corasick (1 pasada, 1 hilo): " << aho_duration.count() << " ms" << std::endl;
+        if (aho_duration.count() > 0) {
+            std::cout << "Speedup Aho-Corasick vs secuencial: "
+                      << sequential_duration.count() / aho_duration.count() << "x" << std::endl;
+        }
+        std::cout << "Tiempo SIMD (1 hilo): " << simd_duration.count() << " ms" << std::endl;
+        if (simd_duration.count() > 0) {
+            std::cout << "Speedup SIMD vs secuencial: "
+                      << sequential_duration.count() / simd_duration.count() << "x" << std::endl;
+        }
+        std::cout << "Tiempo particionando el texto (" << partition_threads << " hilos): "
+                  << partitioned_duration.count() << " ms" << std::endl;
+        if (partitioned_duration.count() > 0) {
+            std::cout << "Speedup texto particionado vs secuencial: "
+                      << sequential_duration.count() / partitioned_duration.count() << "x" << std::endl;
+        }
         
         // Información del sistema
         std::cout << "\n=== INFORMACIÓN DEL SISTEMA ===" << std::endl;
@@ -288,6 +1370,77 @@ public:
         std::cout << "Número de patrones: " << patterns.size() << std::endl;
     }
     
+    // Compara ambos cargadores, cada uno en un proceso hijo propio para que
+    // el pico de memoria residente (ru_maxrss) de uno no contamine al otro
+    static void compare_loaders() {
+        std::cout << "\n=== COMPARACIÓN DE CARGADORES DE TEXTO ===" << std::endl;
+#ifdef PATTERN_SEARCH_HAS_MMAP
+        struct LoaderReport {
+            double load_ms;
+            double first_pass_ms;
+            long peak_rss_after_load_kb;
+            long peak_rss_after_pass_kb;
+        };
+        const std::pair<TextLoader, const char*> loaders[] = {
+            {TextLoader::Mmap, "mmap"},
+            {TextLoader::Ifstream, "ifstream"},
+        };
+        
+        for (const auto& loader : loaders) {
+            int fds[2];
+            if (pipe(fds) != 0) {
+                std::cerr << "Error: no se pudo crear el pipe para " << loader.second << std::endl;
+                continue;
+            }
+            
+            std::cout.flush();
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                LoaderReport report{};
+                
+                auto start_load = std::chrono::high_resolution_clock::now();
+                PatternSearcher searcher(loader.first);
+                auto end_load = std::chrono::high_resolution_clock::now();
+                report.peak_rss_after_load_kb = peak_rss_kb();
+                
+                // Primera pasada completa: con mmap es cuando realmente se leen las páginas
+                searcher.count_patterns_aho_corasick();
+                auto end_pass = std::chrono::high_resolution_clock::now();
+                report.peak_rss_after_pass_kb = peak_rss_kb();
+                
+                report.load_ms = std::chrono::duration<double, std::milli>(end_load - start_load).count();
+                report.first_pass_ms = std::chrono::duration<double, std::milli>(end_pass - end_load).count();
+                
+                std::cout.flush();
+                ssize_t written = write(fds[1], &report, sizeof(report));
+                close(fds[1]);
+                _exit(written == static_cast<ssize_t>(sizeof(report)) ? 0 : 1);
+            }
+            
+            close(fds[1]);
+            LoaderReport report{};
+            ssize_t received = (pid > 0) ? read(fds[0], &report, sizeof(report)) : -1;
+            close(fds[0]);
+            if (pid > 0) {
+                waitpid(pid, nullptr, 0);
+            }
+            
+            if (received != static_cast<ssize_t>(sizeof(report))) {
+                std::cerr << "Error: no se pudo medir el cargador " << loader.second << std::endl;
+                continue;
+            }
+            
+            std::cout << "[" << loader.second << "] carga: " << report.load_ms << " ms"
+                      << ", primera pasada: " << report.first_pass_ms << " ms"
+                      << ", pico RSS tras carga: " << report.peak_rss_after_load_kb / 1024 << " MB"
+                      << ", pico RSS tras pasada: " << report.peak_rss_after_pass_kb / 1024 << " MB" << std::endl;
+        }
+#else
+        std::cout << "mmap no disponible en esta plataforma; solo se usa ifstream" << std::endl;
+#endif
+    }
+    
     // Función para mostrar información de los patrones
     void show_pattern_info() {
         std::cout << "\n=== INFORMACIÓN DE PATRONES ===" << std::endl;
@@ -300,11 +1453,491 @@ public:
     }
 };
 
-int main() {
+#ifdef PATTERN_SEARCH_HAS_SOCKETS
+// Protocolo del modo servidor (socket Unix o entrada/salida estándar): una
+// consulta son patrones de a uno por línea terminados por una línea vacía;
+// la respuesta es un conteo por línea, en el mismo orden, y una línea vacía.
+
+// Lee líneas de un descriptor (socket o entrada estándar) con buffer propio
+class LineReader {
+public:
+    explicit LineReader(int fd) : fd(fd) {}
+    
+    // Devuelve false al llegar al final del flujo o ante un error
+    bool next(std::string& line) {
+        while (true) {
+            size_t newline = buffer.find('\n', scanned);
+            if (newline != std::string::npos) {
+                line.assign(buffer, 0, newline);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                buffer.erase(0, newline + 1);
+                scanned = 0;
+                return true;
+            }
+            scanned = buffer.size();
+            char chunk[4096];
+            ssize_t got = ::read(fd, chunk, sizeof chunk);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            buffer.append(chunk, static_cast<size_t>(got));
+        }
+    }
+    
+private:
+    int fd;
+    std::string buffer;
+    size_t scanned = 0;
+};
+
+static bool write_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::write(fd, data.data() + sent, data.size() - sent);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Lee una consulta completa; un final de flujo sin línea vacía cierra la
+// última consulta. Devuelve false si no quedaba ninguna.
+static bool read_request(LineReader& reader, std::vector<std::string>& request) {
+    request.clear();
+    std::string line;
+    while (reader.next(line)) {
+        if (line.empty()) return true;
+        request.push_back(line);
+    }
+    return !request.empty();
+}
+
+// Resuelve consultas concurrentes agrupándolas: el despachador espera hasta
+// batch_window desde que llega la primera consulta pendiente (o hasta juntar
+// max_batch patrones) y cuenta todos los patrones distintos del lote de una
+// vez: una pasada Aho-Corasick con el texto particionado en el pool
+// compartido o, con el índice de sufijos, un patrón por tarea. El
+// despachador es el único hilo que usa el pool.
+class QueryServer {
+public:
+    QueryServer(const PatternSearcher& searcher, size_t num_threads, std::chrono::microseconds batch_window,
+                size_t max_batch, bool use_index)
+        : searcher(searcher), num_threads(std::max<size_t>(1, num_threads)), batch_window(batch_window),
+          max_batch(std::max<size_t>(1, max_batch)), use_index(use_index) {
+        dispatcher = std::thread(&QueryServer::dispatch_loop, this);
+    }
+    
+    ~QueryServer() {
+        stop();
+    }
+    
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+    
+    // Conteos de pattern_set; bloquea hasta que se resuelve su lote
+    std::vector<size_t> query(const std::vector<std::string>& pattern_set) {
+        if (pattern_set.empty()) {
+            return {};
+        }
+        Pending pending{pattern_set, {}};
+        std::future<std::vector<size_t>> result = pending.result.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(&pending);
+            queued_patterns += pattern_set.size();
+        }
+        arrived.notify_one();
+        return result.get();
+    }
+    
+    // Resuelve lo pendiente y termina el despachador
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        arrived.notify_one();
+        if (dispatcher.joinable()) {
+            dispatcher.join();
+        }
+    }
+    
+    void print_stats(std::ostream& os) const {
+        os << "Lotes: " << batches << ", consultas: " << requests << ", patrones: " << patterns_seen
+           << ", patrones distintos contados: " << patterns_counted;
+        if (batches > 0) {
+            os << " (" << (double)requests / batches << " consultas por lote)";
+        }
+        os << std::endl;
+    }
+    
+private:
+    struct Pending {
+        std::vector<std::string> patterns;
+        std::promise<std::vector<size_t>> result;
+    };
+    
+    void dispatch_loop() {
+        while (true) {
+            std::vector<Pending*> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                arrived.wait(lock, [&]() { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                arrived.wait_for(lock, batch_window, [&]() { return stopping || queued_patterns >= max_batch; });
+                batch.assign(queue.begin(), queue.end());
+                queue.clear();
+                queued_patterns = 0;
+            }
+            
+            // Cada patrón distinto se cuenta una sola vez por lote
+            std::vector<std::string> distinct;
+            std::unordered_map<std::string, size_t> slot;
+            for (Pending* pending : batch) {
+                for (const std::string& pattern : pending->patterns) {
+                    if (slot.emplace(pattern, distinct.size()).second) {
+                        distinct.push_back(pattern);
+                    }
+                }
+                patterns_seen += pending->patterns.size();
+            }
+            
+            try {
+                std::vector<size_t> counts = use_index
+                    ? searcher.count_patterns_suffix_array(distinct, num_threads)
+                    : searcher.count_patterns_text_partitioned(distinct, num_threads);
+                for (Pending* pending : batch) {
+                    std::vector<size_t> answer;
+                    answer.reserve(pending->patterns.size());
+                    for (const std::string& pattern : pending->patterns) {
+                        answer.push_back(counts[slot[pattern]]);
+                    }
+                    pending->result.set_value(std::move(answer));
+                }
+            } catch (...) {
+                for (Pending* pending : batch) {
+                    pending->result.set_exception(std::current_exception());
+                }
+            }
+            batches++;
+            requests += batch.size();
+            patterns_counted += distinct.size();
+        }
+    }
+    
+    const PatternSearcher& searcher;
+    const size_t num_threads;
+    const std::chrono::microseconds batch_window;
+    const size_t max_batch;
+    const bool use_index;
+    
+    std::mutex mutex;
+    std::condition_variable arrived;
+    std::deque<Pending*> queue;
+    size_t queued_patterns = 0;
+    bool stopping = false;
+    std::thread dispatcher;
+    
+    // Solo los escribe el despachador; se leen después de stop()
+    uint64_t batches = 0;
+    uint64_t requests = 0;
+    uint64_t patterns_seen = 0;
+    uint64_t patterns_counted = 0;
+};
+
+// Atiende consultas de un cliente hasta que cierra la conexión
+static void serve_connection(QueryServer& server, int in_fd, int out_fd) {
+    LineReader reader(in_fd);
+    std::vector<std::string> request;
+    while (read_request(reader, request)) {
+        std::string reply;
+        for (size_t count : server.query(request)) {
+            reply += std::to_string(count);
+            reply += '\n';
+        }
+        reply += '\n';
+        if (!write_all(out_fd, reply)) {
+            break;
+        }
+    }
+}
+
+static volatile std::sig_atomic_t server_stop_requested = 0;
+
+static void request_server_stop(int) {
+    server_stop_requested = 1;
+}
+
+static bool make_socket_address(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof address.sun_path) {
+        std::cerr << "Error: ruta de socket demasiado larga: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Modo servidor (--serve): carga el texto una vez y responde consultas por
+// el socket Unix de --socket, un hilo por conexión, o por la entrada
+// estándar si no se indica socket. Termina con SIGINT/SIGTERM o, en modo
+// entrada estándar, al cerrarse la entrada.
+int run_server(const BenchArgs& args) {
+    const size_t threads = (size_t)std::max<long long>(1, args.get_int("threads", std::max(1u, std::thread::hardware_concurrency())));
+    const std::string socket_path = args.get("socket", "");
+    const bool use_index = args.has("index");
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    // Los mensajes van a stderr: en modo entrada estándar stdout lleva las respuestas
+    std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+    PatternSearcher searcher;
+    if (use_index) {
+        double build_ms = 0;
+        if (searcher.prepare_suffix_index("texto_ej2.sa", threads, &build_ms)) {
+            std::cerr << "Índice de sufijos proyectado desde texto_ej2.sa" << std::endl;
+        } else {
+            std::cerr << "Índice de sufijos construido en " << build_ms << " ms" << std::endl;
+        }
+    }
+    QueryServer server(searcher, threads, std::chrono::microseconds(args.get_int("batch-window-us", 1000)),
+                       (size_t)args.get_int("max-batch", 1024), use_index);
+    
+    if (socket_path.empty()) {
+        std::cerr << "Atendiendo consultas por la entrada estándar (" << threads << " hilos"
+                  << (use_index ? ", índice de sufijos" : ", Aho-Corasick") << ")" << std::endl;
+        serve_connection(server, STDIN_FILENO, STDOUT_FILENO);
+    } else {
+        sockaddr_un address;
+        if (!make_socket_address(socket_path, address)) {
+            std::cout.rdbuf(stdout_buffer);
+            return 1;
+        }
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(socket_path.c_str());
+        if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0 ||
+            listen(listener, 64) != 0) {
+            std::cerr << "Error: no se pudo escuchar en " << socket_path << ": " << std::strerror(errno) << std::endl;
+            if (listener >= 0) close(listener);
+            std::cout.rdbuf(stdout_buffer);
+            return 1;
+        }
+        std::signal(SIGINT, request_server_stop);
+        std::signal(SIGTERM, request_server_stop);
+        std::cerr << "Escuchando en " << socket_path << " (" << threads << " hilos"
+                  << (use_index ? ", índice de sufijos" : ", Aho-Corasick") << ")" << std::endl;
+        
+        struct Client {
+            int fd;
+            std::shared_ptr<std::atomic<bool>> finished;
+            std::thread thread;
+        };
+        std::vector<Client> clients;
+        auto reap = [&clients](bool all) {
+            for (auto it = clients.begin(); it != clients.end();) {
+                if (!all && !it->finished->load()) {
+                    ++it;
+                    continue;
+                }
+                if (all) shutdown(it->fd, SHUT_RDWR);
+                it->thread.join();
+                close(it->fd);
+                it = clients.erase(it);
+            }
+        };
+        
+        while (!server_stop_requested) {
+            pollfd ready{listener, POLLIN, 0};
+            if (poll(&ready, 1, 200) <= 0) {
+                continue;
+            }
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            auto finished = std::make_shared<std::atomic<bool>>(false);
+            clients.push_back({fd, finished, std::thread([&server, fd, finished]() {
+                serve_connection(server, fd, fd);
+                finished->store(true);
+            })});
+            reap(false);
+        }
+        
+        close(listener);
+        unlink(socket_path.c_str());
+        reap(true);
+    }
+    
+    server.stop();
+    server.print_stats(std::cerr);
+    std::cout.rdbuf(stdout_buffer);
+    return 0;
+}
+
+// Generador de carga (--client): --connections conexiones concurrentes
+// envían --requests consultas cada una, de --batch patrones elegidos al azar
+// de patrones.txt, y se informa la latencia p50/p99 y las consultas por segundo
+int run_load_client(const BenchArgs& args) {
+    const std::string socket_path = args.get("socket", "ej2.sock");
+    const size_t connections = (size_t)std::max<long long>(1, args.get_int("connections", 4));
+    const size_t requests = (size_t)std::max<long long>(1, args.get_int("requests", 200));
+    const size_t batch = (size_t)std::max<long long>(1, args.get_int("batch", 4));
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    std::vector<std::string> pool_patterns;
+    std::ifstream file(args.get("patterns", "patrones.txt"));
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) pool_patterns.push_back(line);
+    }
+    if (pool_patterns.empty()) {
+        std::cerr << "Error: no hay patrones para enviar" << std::endl;
+        return 1;
+    }
+    sockaddr_un address;
+    if (!make_socket_address(socket_path, address)) {
+        return 1;
+    }
+    
+    std::vector<std::vector<double>> latencies(connections);
+    std::atomic<size_t> failures(0);
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t c = 0; c < connections; c++) {
+        workers.emplace_back([&, c]() {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof address) != 0) {
+                std::cerr << "Error: no se pudo conectar a " << socket_path << ": " << std::strerror(errno) << std::endl;
+                if (fd >= 0) close(fd);
+                failures += requests;
+                return;
+            }
+            std::mt19937 rng((unsigned)c + 1);
+            LineReader reader(fd);
+            std::vector<std::string> reply;
+            latencies[c].reserve(requests);
+            for (size_t r = 0; r < requests; r++) {
+                std::string request;
+                for (size_t b = 0; b < batch; b++) {
+                    request += pool_patterns[rng() % pool_patterns.size()];
+                    request += '\n';
+                }
+                request += '\n';
+                
+                auto sent = std::chrono::steady_clock::now();
+                if (!write_all(fd, request) || !read_request(reader, reply) || reply.size() != batch) {
+                    failures += requests - r;
+                    break;
+                }
+                latencies[c].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sent).count());
+            }
+            close(fd);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    
+    std::vector<double> all;
+    for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double q) {
+        return all.empty() ? 0.0 : all[std::min(all.size() - 1, (size_t)(q * (double)all.size()))];
+    };
+    
+    std::cout << "\n=== CLIENTE DE CARGA ===" << std::endl;
+    std::cout << "Conexiones: " << connections << ", consultas: " << all.size()
+              << ", patrones por consulta: " << batch << std::endl;
+    std::cout << "Latencia p50: " << percentile(0.50) << " ms, p99: " << percentile(0.99)
+              << " ms, máx: " << (all.empty() ? 0.0 : all.back()) << " ms" << std::endl;
+    if (seconds > 0) {
+        std::cout << "Consultas por segundo: " << all.size() / seconds
+                  << " (" << all.size() * batch / seconds << " patrones por segundo)" << std::endl;
+    }
+    if (failures > 0) {
+        std::cerr << "ADVERTENCIA: " << failures.load() << " consultas sin respuesta" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+// Barrido de hilos y tamaños de texto con el arnés común (--bench)
+int run_benchmark(const BenchArgs& args) {
+    // Los mensajes de carga van a stderr para no mezclarse con CSV/JSON
+    std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+    PatternSearcher searcher;
+    std::cout.rdbuf(stdout_buffer);
+    const long long full = (long long)searcher.loaded_size();
+    BenchReport report("ej2");
+    
+    for (long long bytes : args.get_list("sizes", {full / 4, full / 2, full})) {
+        searcher.limit_text((size_t)bytes);
+        for (long long threads : args.threads()) {
+            report.run(args, "search_patterns_thread_pool", bytes, (int)threads, [&]() {
+                searcher.count_patterns_kmp_pool((size_t)threads);
+            });
+            report.run(args, "search_patterns_text_partitioned", bytes, (int)threads, [&]() {
+                searcher.count_patterns_text_partitioned((size_t)threads);
+            });
+            if (args.has("index")) {
+                report.run(args, "suffix_array_build", bytes, (int)threads, [&]() {
+                    searcher.build_suffix_index((size_t)threads);
+                });
+            }
+        }
+        // Las consultas son secuenciales: todos los patrones sobre el índice ya construido
+        if (args.has("index")) {
+            report.run(args, "search_patterns_suffix_array", bytes, 1, [&]() {
+                searcher.count_patterns_suffix_array();
+            });
+        }
+    }
+    searcher.limit_text((size_t)full);
+    report.print(args);
+    if (perf_regions_enabled()) perf_regions_report(std::cout);
+    return 0;
+}
+
+// Uso / Usage:
+//   ej2                       corrida completa / full run
+//   ej2 --index               corrida completa más el índice de sufijos en texto_ej2.sa
+//                             full run plus the suffix array index in texto_ej2.sa
+//   ej2 --bench [--sizes 1e6,1e7] [--threads 1,2,4] [--reps 5] [--format csv|json] [--out archivo]
+//   --index agrega al barrido la construcción y las consultas del arreglo de sufijos
+//           adds suffix array construction and queries to the sweep
+//   ej2 --serve [--socket ej2.sock] [--threads 4] [--index] [--batch-window-us 1000] [--max-batch 1024]
+//           servidor residente; sin --socket atiende por stdin/stdout
+//           resident server; without --socket it serves stdin/stdout
+//   ej2 --client [--socket ej2.sock] [--connections 4] [--requests 200] [--batch 4]
+//           generador de carga: latencia p50/p99 y consultas por segundo
+//           load generator: p50/p99 latency and queries per second
+//   --perf agrega contadores de hardware por fase / adds per-phase hardware counters
+int main(int argc, char* argv[]) {
+    BenchArgs args(argc, argv);
+    if (args.has("perf")) perf_regions_enable();
+    
+    try {
+        if (args.has("bench")) return run_benchmark(args);
+#ifdef PATTERN_SEARCH_HAS_SOCKETS
+        if (args.has("serve")) return run_server(args);
+        if (args.has("client")) return run_load_client(args);
+#endif
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
     std::cout << "=== PROGRAMA DE BÚSQUEDA DE PATRONES ===" << std::endl;
     std::cout << "Trabajo Práctico N°1" << std::endl;
     
     try {
+        // Antes de cargar el texto en este proceso, para medir cada cargador por separado
+        PatternSearcher::compare_loaders();
+        
         PatternSearcher searcher;
         
         // Mostrar información de los patrones
@@ -313,6 +1946,22 @@ int main() {
         // Realizar benchmark completo
         searcher.benchmark_comparison();
         
+        // Rendimiento por patrón del kernel vectorizado
+        searcher.search_patterns_simd();
+        
+        // Misma búsqueda leyendo el archivo por bloques, con memoria acotada
+        searcher.search_patterns_streaming("texto_ej2.txt", 8 * 1024 * 1024);
+        
+        // Índice de sufijos persistente (--index): se construye una vez y luego
+        // se proyecta. Ocupa 4 bytes por carácter en disco y la construcción
+        // usa unas 10 veces el tamaño del texto en memoria.
+        if (args.has("index")) {
+            searcher.search_patterns_suffix_array("texto_ej2.sa", std::max(1u, std::thread::hardware_concurrency()));
+        }
+        
+        // Contadores de hardware por fase (--perf): carga frente a búsqueda
+        if (perf_regions_enabled()) perf_regions_report(std::cout);
+        
         std::cout << "\n=== INSTRUCCIONES PARA MONITOREO ===" << std::endl;
         std::cout << "Para observar el uso de CPU por núcleo:" << std::endl;
         std::cout << "- Windows: Usar el Administrador de tareas (Ctrl+Shift+Esc)" << std::endl;
@@ -331,10 +1980,11 @@ int main() {
 Instrucciones de compilación y ejecución:
 
 1. Compilar:
-   g++ -std=c++11 -O3 -pthread -o pattern_search pattern_search.cpp
+   g++ -std=c++17 -O3 -pthread -o pattern_search pattern_search.cpp
 
 2. Ejecutar:
    ./pattern_search
+   ./pattern_search --bench --threads 1,2,4,8 --format csv --out ej2.csv
 
 3. Para monitoreo de CPU:
    - Ejecutar el programa en una terminal
@@ -346,7 +1996,24 @@ Instrucciones de compilación y ejecución:
    - patrones.txt (archivo con 32 patrones, uno por línea)
 
 Notas de optimización:
+- El kernel SIMD compara primer y último byte del patrón en 32 (AVX2) o 16
+  (SSE2) posiciones por iteración y verifica solo los candidatos; se elige
+  en tiempo de ejecución según la CPU, con alternativa escalar
+- El modo streaming lee el archivo por bloques con doble buffer y arrastra
+  el estado del autómata entre bloques, para archivos mayores que la RAM
+- El texto se proyecta con mmap (sin copia, con madvise secuencial); si no
+  es posible se lee con ifstream. Las búsquedas trabajan sobre string_view
 - Usa algoritmo KMP para búsqueda eficiente
+- El arreglo de sufijos (texto_ej2.sa, 4 bytes por carácter) se construye
+  una vez en paralelo y luego se proyecta con mmap; cada conteo son dos
+  búsquedas binarias, O(m log n), en lugar de recorrer el texto. Se
+  reconstruye solo si cambia el tamaño o el hash del texto
+- El modo servidor (--serve) deja el texto (y con --index el arreglo de
+  sufijos) residente; las consultas que llegan dentro de la ventana de
+  agrupamiento se cuentan juntas en una sola pasada Aho-Corasick
+- Aho-Corasick cuenta todos los patrones en una sola pasada sobre el texto
+- El modo particionado reparte el texto (no los patrones) entre hilos, con
+  solapamiento de (longitud máxima - 1) bytes en cada borde
 - Implementa pool de hilos para mejor balanceo de carga
 - Minimiza sincronización entre hilos
 - Usa atomic para contador de patrones
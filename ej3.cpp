@@ -3,19 +3,115 @@
 #include <thread>
 #include <sys/time.h>  // para gettimeofday
 #include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <functional>
+#include <cmath>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <cerrno>
+#include <fcntl.h>     // open, posix_fadvise
+#include <unistd.h>    // pread, pwrite, ftruncate
+
+#include "bench.h"        // arnés de benchmark común (--bench)
+#include "perf_counters.h" // contadores de hardware por región (--perf)
+#include "thread_pool.h"  // WorkStealingPool compartido con ej1, ej2 y ej4
 
 using namespace std;
 
-using Matrix = vector<vector<float>>;
+// Vista (no propietaria) de una submatriz con paso de fila arbitrario
+template <typename T>
+struct MatrixViewT {
+    T *data;
+    int rows;
+    int cols;
+    size_t stride;  // elementos entre el inicio de filas consecutivas
+
+    T *operator[](int i) const { return data + (size_t)i * stride; }
+
+    // Sub-bloque de rowsCount x colsCount que empieza en (r0, c0)
+    MatrixViewT block(int r0, int c0, int rowsCount, int colsCount) const {
+        return {data + (size_t)r0 * stride + c0, rowsCount, colsCount, stride};
+    }
+};
+using MatrixView = MatrixViewT<float>;
+using ConstMatrixView = MatrixViewT<const float>;
+
+// Matriz cuadrada N x N en un único buffer contiguo alineado a 64 bytes.
+// Cada fila se rellena hasta un múltiplo de 16 floats para que todas
+// empiecen en una línea de caché. Solo se puede mover, no copiar.
+class Matrix {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    Matrix() = default;
+
+    explicit Matrix(int N, float value = 0.0f)
+        : n(N), ld(((size_t)N + 15) / 16 * 16) {
+        size_t bytes = (size_t)n * ld * sizeof(float);
+        if(bytes == 0) return;
+        buffer.reset(static_cast<float *>(aligned_alloc(ALIGNMENT, bytes)));
+        if(!buffer) throw bad_alloc();
+        memset(buffer.get(), 0, bytes);
+        if(value != 0.0f)
+            for(int i = 0; i < n; i++)
+                fill((*this)[i], (*this)[i] + n, value);
+    }
+
+    Matrix(Matrix &&) noexcept = default;
+    Matrix &operator=(Matrix &&) noexcept = default;
+    Matrix(const Matrix &) = delete;
+    Matrix &operator=(const Matrix &) = delete;
+
+    float *operator[](int i) { return buffer.get() + (size_t)i * ld; }
+    const float *operator[](int i) const { return buffer.get() + (size_t)i * ld; }
+
+    int size() const { return n; }
+    size_t stride() const { return ld; }
+    size_t bytes() const { return (size_t)n * ld * sizeof(float); }
+
+    MatrixView view() { return {buffer.get(), n, n, ld}; }
+    ConstMatrixView view() const { return {buffer.get(), n, n, ld}; }
+
+private:
+    struct FreeDeleter {
+        void operator()(float *p) const { free(p); }
+    };
+
+    unique_ptr<float, FreeDeleter> buffer;
+    int n = 0;
+    size_t ld = 0;
+};
+
+// Disposición anterior (una asignación por fila), solo para comparar
+using NestedMatrix = vector<vector<float>>;
+
+// Núcleo de multiplicación a usar por los drivers secuencial y paralelo
+enum class Kernel {
+    Naive,  // bucle i-j-k original
+    Tiled   // bloques para L1/L2, orden i-k-j y micro-kernel en registros
+};
+
+// Parámetros del núcleo por bloques
+const int TILE_K = 256;   // filas de B por bloque (panel de B de TILE_K x TILE_J en L2)
+const int TILE_J = 256;   // columnas de B/C por bloque
+const int MICRO_ROWS = 4; // filas de C que acumula el micro-kernel
+const int MICRO_COLS = 16; // columnas de C que acumula el micro-kernel (vectorizable)
 
 // Inicializar matriz con un valor fijo
 Matrix initMatrix(int N, float value) {
-    return Matrix(N, vector<float>(N, value));
+    return Matrix(N, value);
 }
 
 // Multiplicación secuencial
 Matrix multiplySequential(const Matrix &A, const Matrix &B, int N) {
-    Matrix C(N, vector<float>(N, 0.0f));
+    Matrix C(N);
     for(int i = 0; i < N; i++) {
         for(int j = 0; j < N; j++) {
             for(int k = 0; k < N; k++) {
@@ -26,34 +122,308 @@ Matrix multiplySequential(const Matrix &A, const Matrix &B, int N) {
     return C;
 }
 
-// Multiplicación de un bloque de filas (para los hilos)
-void multiplyBlock(const Matrix &A, const Matrix &B, Matrix &C, int startRow, int endRow, int N) {
-    for(int i = startRow; i < endRow; i++) {
-        for(int j = 0; j < N; j++) {
-            for(int k = 0; k < N; k++) {
+// Multiplicación i-j-k original de la región [i0, i1) x [j0, j1) de C (para los tiles)
+void multiplyTileNaive(ConstMatrixView A, ConstMatrixView B, MatrixView C, int i0, int i1, int j0, int j1) {
+    const int K = A.cols;
+    for(int i = i0; i < i1; i++) {
+        for(int j = j0; j < j1; j++) {
+            for(int k = 0; k < K; k++) {
                 C[i][j] += A[i][k] * B[k][j];
             }
         }
     }
 }
 
-// Multiplicación paralela
-Matrix multiplyParallel(const Matrix &A, const Matrix &B, int N, int numThreads) {
-    Matrix C(N, vector<float>(N, 0.0f));
-    vector<thread> threads;
-    int blockSize = N / numThreads;
-    int startRow = 0;
+// Micro-kernel: C[i0..i0+MICRO_ROWS) x [j0..j0+MICRO_COLS) += A[., k0..k1) * B[k0..k1, .)
+// Los acumuladores viven en registros y el bucle interno en j es vectorizable
+static inline void microKernel(ConstMatrixView A, ConstMatrixView B, MatrixView C,
+                               int i0, int j0, int k0, int k1) {
+    float acc[MICRO_ROWS][MICRO_COLS];
+    const float *aRow[MICRO_ROWS];
+    for(int r = 0; r < MICRO_ROWS; r++) {
+        aRow[r] = A[i0 + r];
+        for(int c = 0; c < MICRO_COLS; c++)
+            acc[r][c] = C[i0 + r][j0 + c];
+    }
+
+    const float *b = B[k0] + j0;
+    for(int k = k0; k < k1; k++, b += B.stride) {
+        for(int r = 0; r < MICRO_ROWS; r++) {
+            float a = aRow[r][k];
+            for(int c = 0; c < MICRO_COLS; c++)
+                acc[r][c] += a * b[c];
+        }
+    }
+
+    for(int r = 0; r < MICRO_ROWS; r++)
+        for(int c = 0; c < MICRO_COLS; c++)
+            C[i0 + r][j0 + c] = acc[r][c];
+}
+
+// Bordes que no completan un micro-bloque: orden i-k-j escalar
+static inline void edgeKernel(ConstMatrixView A, ConstMatrixView B, MatrixView C,
+                              int i0, int i1, int j0, int j1, int k0, int k1) {
+    for(int i = i0; i < i1; i++)
+        for(int k = k0; k < k1; k++) {
+            float a = A[i][k];
+            const float *b = B[k];
+            for(int j = j0; j < j1; j++)
+                C[i][j] += a * b[j];
+        }
+}
+
+// Multiplicación por bloques de la región [i0, i1) x [j0, j1) de C:
+// C += A * B, con A de C.rows x A.cols y B de A.cols x C.cols
+void multiplyTile(ConstMatrixView A, ConstMatrixView B, MatrixView C, int i0, int i1, int j0, int j1) {
+    const int K = A.cols;
+    for(int jj = j0; jj < j1; jj += TILE_J) {
+        int jEnd = min(jj + TILE_J, j1);
+        for(int kk = 0; kk < K; kk += TILE_K) {
+            int kEnd = min(kk + TILE_K, K);
+            int i = i0;
+            for(; i + MICRO_ROWS <= i1; i += MICRO_ROWS) {
+                int j = jj;
+                for(; j + MICRO_COLS <= jEnd; j += MICRO_COLS)
+                    microKernel(A, B, C, i, j, kk, kEnd);
+                edgeKernel(A, B, C, i, i + MICRO_ROWS, j, jEnd, kk, kEnd);
+            }
+            edgeKernel(A, B, C, i, i1, jj, jEnd, kk, kEnd);
+        }
+    }
+}
+
+// Multiplicación secuencial por bloques
+Matrix multiplySequentialTiled(const Matrix &A, const Matrix &B, int N) {
+    Matrix C(N);
+    multiplyTile(A.view(), B.view(), C.view(), 0, N, 0, N);
+    return C;
+}
+
+// Multiplicación paralela por tiles 2D de C (tileSize x tileSize) repartidos
+// en un pool persistente con robo de trabajo; kernel elige el núcleo de cada tile
+Matrix multiplyParallelTiles(const Matrix &A, const Matrix &B, int N, WorkStealingPool &pool, int tileSize,
+                             Kernel kernel = Kernel::Tiled) {
+    Matrix C(N);
+    tileSize = max(1, tileSize);
+    int tilesPerSide = (N + tileSize - 1) / tileSize;
+
+    ConstMatrixView a = A.view(), b = B.view();
+    MatrixView c = C.view();
+    pool.run(tilesPerSide * tilesPerSide, [&](int t) {
+        int i0 = (t / tilesPerSide) * tileSize;
+        int j0 = (t % tilesPerSide) * tileSize;
+        int i1 = min(i0 + tileSize, N), j1 = min(j0 + tileSize, N);
+        if(kernel == Kernel::Tiled) {
+            PerfScope scope("ej3/multiplyTile");
+            multiplyTile(a, b, c, i0, i1, j0, j1);
+        } else {
+            PerfScope scope("ej3/multiplyTileNaive");
+            multiplyTileNaive(a, b, c, i0, i1, j0, j1);
+        }
+    });
+
+    return C;
+}
+
+// Multiplicación paralela en el pool compartido de numThreads participantes,
+// por tiles 2D: reparte bien aunque N no sea múltiplo de la cantidad de hilos
+Matrix multiplyParallel(const Matrix &A, const Matrix &B, int N, int numThreads,
+                        Kernel kernel = Kernel::Naive, int tileSize = 128) {
+    return multiplyParallelTiles(A, B, N, WorkStealingPool::shared(numThreads), tileSize, kernel);
+}
+
+// ---------------- STRASSEN-WINOGRAD ----------------
+
+// Paso de fila para los temporales del arena (múltiplo de 16 floats)
+static inline size_t arenaStride(int n) {
+    return ((size_t)n + 15) / 16 * 16;
+}
+
+// Toma un bloque n x n del arena y avanza el puntero
+static inline MatrixView takeFromArena(float *&arena, int n) {
+    MatrixView v{arena, n, n, arenaStride(n)};
+    arena += (size_t)n * v.stride;
+    return v;
+}
+
+// Z = X + Y  /  Z = X - Y (elemento a elemento)
+static void addViews(ConstMatrixView X, ConstMatrixView Y, MatrixView Z) {
+    for(int i = 0; i < Z.rows; i++) {
+        const float *x = X[i], *y = Y[i];
+        float *z = Z[i];
+        for(int j = 0; j < Z.cols; j++) z[j] = x[j] + y[j];
+    }
+}
+
+static void subViews(ConstMatrixView X, ConstMatrixView Y, MatrixView Z) {
+    for(int i = 0; i < Z.rows; i++) {
+        const float *x = X[i], *y = Y[i];
+        float *z = Z[i];
+        for(int j = 0; j < Z.cols; j++) z[j] = x[j] - y[j];
+    }
+}
+
+static ConstMatrixView asConst(MatrixView v) {
+    return {v.data, v.rows, v.cols, v.stride};
+}
+
+// Temporales de un nivel de Strassen-Winograd: S1..S4, T1..T4 y M1..M7
+struct StrassenLevel {
+    MatrixView S[4], T[4], M[7];
+};
+
+static const int STRASSEN_TEMPS = 15;
+
+// Floats de arena que necesita un producto n x n: con subproblemas
+// secuenciales los 7 hijos reutilizan la misma región; con subproblemas
+// paralelos cada hijo tiene la suya
+size_t strassenArenaSize(int n, int cutoff, int parallelLevels) {
+    if(n <= cutoff || n % 2 != 0) return 0;
+    int h = n / 2;
+    size_t level = STRASSEN_TEMPS * (size_t)h * arenaStride(h);
+    size_t child = strassenArenaSize(h, cutoff, max(0, parallelLevels - 1));
+    return level + (parallelLevels > 0 ? 7 * child : child);
+}
+
+// Calcula S y T de un nivel y devuelve los operandos de los 7 productos
+static StrassenLevel strassenSplit(ConstMatrixView A, ConstMatrixView B, float *&arena,
+                                   ConstMatrixView Aop[7], ConstMatrixView Bop[7]) {
+    int h = A.rows / 2;
+    ConstMatrixView A11 = A.block(0, 0, h, h), A12 = A.block(0, h, h, h);
+    ConstMatrixView A21 = A.block(h, 0, h, h), A22 = A.block(h, h, h, h);
+    ConstMatrixView B11 = B.block(0, 0, h, h), B12 = B.block(0, h, h, h);
+    ConstMatrixView B21 = B.block(h, 0, h, h), B22 = B.block(h, h, h, h);
+
+    StrassenLevel L;
+    for(auto &v : L.S) v = takeFromArena(arena, h);
+    for(auto &v : L.T) v = takeFromArena(arena, h);
+    for(auto &v : L.M) v = takeFromArena(arena, h);
+
+    addViews(A21, A22, L.S[0]);            // S1 = A21 + A22
+    subViews(asConst(L.S[0]), A11, L.S[1]); // S2 = S1 - A11
+    subViews(A11, A21, L.S[2]);            // S3 = A11 - A21
+    subViews(A12, asConst(L.S[1]), L.S[3]); // S4 = A12 - S2
+    subViews(B12, B11, L.T[0]);            // T1 = B12 - B11
+    subViews(B22, asConst(L.T[0]), L.T[1]); // T2 = B22 - T1
+    subViews(B22, B12, L.T[2]);            // T3 = B22 - B12
+    subViews(asConst(L.T[1]), B21, L.T[3]); // T4 = T2 - B21
+
+    // M1 = A11·B11, M2 = A12·B21, M3 = S4·B22, M4 = A22·T4,
+    // M5 = S1·T1,   M6 = S2·T2,   M7 = S3·T3
+    ConstMatrixView as[7] = {A11, A12, asConst(L.S[3]), A22, asConst(L.S[0]), asConst(L.S[1]), asConst(L.S[2])};
+    ConstMatrixView bs[7] = {B11, B21, B22, asConst(L.T[3]), asConst(L.T[0]), asConst(L.T[1]), asConst(L.T[2])};
+    for(int p = 0; p < 7; p++) {
+        Aop[p] = as[p];
+        Bop[p] = bs[p];
+    }
+    return L;
+}
+
+// Combina M1..M7 en los cuadrantes de C (los M se usan como temporales)
+static void strassenCombine(StrassenLevel &L, MatrixView C) {
+    int h = C.rows / 2;
+    MatrixView *M = L.M;
+    addViews(asConst(M[0]), asConst(M[1]), C.block(0, 0, h, h)); // C11 = M1 + M2
+    addViews(asConst(M[5]), asConst(M[0]), M[5]);                // U2 = M1 + M6
+    addViews(asConst(M[6]), asConst(M[5]), M[6]);                // U3 = U2 + M7
+    addViews(asConst(M[5]), asConst(M[4]), M[5]);                // U4 = U2 + M5
+    addViews(asConst(M[5]), asConst(M[2]), C.block(0, h, h, h)); // C12 = U4 + M3
+    subViews(asConst(M[6]), asConst(M[3]), C.block(h, 0, h, h)); // C21 = U3 - M4
+    addViews(asConst(M[6]), asConst(M[4]), C.block(h, h, h, h)); // C22 = U3 + M5
+}
 
-    for(int t = 0; t < numThreads; t++) {
-        int endRow = (t == numThreads - 1) ? N : startRow + blockSize;
-        threads.emplace_back(multiplyBlock, cref(A), cref(B), ref(C), startRow, endRow, N);
-        startRow = endRow;
+// Caso base: C = A·B con el núcleo por bloques
+static void strassenBase(ConstMatrixView A, ConstMatrixView B, MatrixView C) {
+    for(int i = 0; i < C.rows; i++) fill(C[i], C[i] + C.cols, 0.0f);
+    multiplyTile(A, B, C, 0, C.rows, 0, C.cols);
+}
+
+// Recursión secuencial: C = A·B, temporales tomados de arena
+void strassenSequential(ConstMatrixView A, ConstMatrixView B, MatrixView C, float *arena, int cutoff) {
+    int n = A.rows;
+    if(n <= cutoff || n % 2 != 0) {
+        strassenBase(A, B, C);
+        return;
     }
+    ConstMatrixView Aop[7], Bop[7];
+    StrassenLevel L = strassenSplit(A, B, arena, Aop, Bop);
+    for(int p = 0; p < 7; p++)
+        strassenSequential(Aop[p], Bop[p], L.M[p], arena, cutoff);
+    strassenCombine(L, C);
+}
+
+// Subproducto pendiente de ejecutar en paralelo
+struct StrassenLeaf {
+    ConstMatrixView A, B;
+    MatrixView C;
+    float *arena;
+};
 
-    for(auto &th : threads) {
-        th.join();
+// Expande los primeros niveles en productos independientes (hojas) y
+// registra las combinaciones en post-orden para aplicarlas después
+static void strassenExpand(ConstMatrixView A, ConstMatrixView B, MatrixView C, float *arena,
+                           int cutoff, int parallelLevels,
+                           vector<StrassenLeaf> &leaves, vector<pair<StrassenLevel, MatrixView>> &combines) {
+    int n = A.rows;
+    if(parallelLevels == 0 || n <= cutoff || n % 2 != 0) {
+        leaves.push_back({A, B, C, arena});
+        return;
+    }
+    ConstMatrixView Aop[7], Bop[7];
+    StrassenLevel L = strassenSplit(A, B, arena, Aop, Bop);
+    size_t child = strassenArenaSize(n / 2, cutoff, parallelLevels - 1);
+    for(int p = 0; p < 7; p++)
+        strassenExpand(Aop[p], Bop[p], L.M[p], arena + p * child, cutoff, parallelLevels - 1, leaves, combines);
+    combines.push_back({L, C});
+}
+
+// Multiplicación Strassen-Winograd: por encima de cutoff divide en 7
+// subproductos, por debajo usa el núcleo por bloques. Los primeros niveles
+// se reparten en el pool (7 o 49 subproblemas); todos los temporales salen
+// de un único arena reservado de antemano.
+Matrix multiplyStrassen(const Matrix &A, const Matrix &B, int N, WorkStealingPool &pool, int cutoff) {
+    cutoff = max(cutoff, MICRO_COLS);
+
+    // Tamaño con relleno de ceros para poder dividir por 2 hasta llegar al corte
+    int levels = 0, m = N;
+    while(m > cutoff) {
+        m = (m + 1) / 2;
+        levels++;
+    }
+    int P = m << levels;
+    int parallelLevels = min(levels, pool.size() > 7 ? 2 : (pool.size() > 1 ? 1 : 0));
+
+    const Matrix *pa = &A, *pb = &B;
+    Matrix Apad, Bpad;
+    if(P != N) {
+        Apad = Matrix(P);
+        Bpad = Matrix(P);
+        for(int i = 0; i < N; i++) {
+            copy(A[i], A[i] + N, Apad[i]);
+            copy(B[i], B[i] + N, Bpad[i]);
+        }
+        pa = &Apad;
+        pb = &Bpad;
     }
 
+    Matrix Cpad(P);
+    vector<float> arena(strassenArenaSize(P, cutoff, parallelLevels));
+
+    vector<StrassenLeaf> leaves;
+    vector<pair<StrassenLevel, MatrixView>> combines;
+    strassenExpand(pa->view(), pb->view(), Cpad.view(), arena.data(), cutoff, parallelLevels, leaves, combines);
+
+    pool.run((int)leaves.size(), [&](int t) {
+        StrassenLeaf &leaf = leaves[t];
+        strassenSequential(leaf.A, leaf.B, leaf.C, leaf.arena, cutoff);
+    });
+    for(auto &c : combines)
+        strassenCombine(c.first, c.second);
+
+    if(P == N) return Cpad;
+    Matrix C(N);
+    for(int i = 0; i < N; i++)
+        copy(Cpad[i], Cpad[i] + N, C[i]);
     return C;
 }
 
@@ -66,6 +436,553 @@ double sumMatrix(const Matrix &M, int N) {
     return total;
 }
 
+// GFLOP/s de una multiplicación N x N (2·N³ operaciones)
+double gflops(int N, double seconds) {
+    return seconds > 0 ? 2.0 * N * N * (double)N / seconds / 1e9 : 0.0;
+}
+
+// Bytes reservados en el heap por una NestedMatrix (cabeceras de vector y
+// de malloc incluidas, asumiendo 16 bytes de cabecera y alineación de 16)
+size_t nestedFootprint(int N) {
+    size_t row = ((size_t)N * sizeof(float) + 16 + 15) / 16 * 16;
+    return sizeof(NestedMatrix) + (size_t)N * sizeof(vector<float>) + 16 + (size_t)N * row;
+}
+
+// Segundos transcurridos desde t1
+double elapsedSince(const timeval &t1) {
+    timeval t2;
+    gettimeofday(&t2, NULL);
+    return double(t2.tv_sec - t1.tv_sec) + double(t2.tv_usec - t1.tv_usec) / 1000000.0;
+}
+
+// Compara memoria y tiempos de la disposición anidada anterior con la contigua:
+// creación, recorrido por filas y recorrido por columnas (el patrón de B[k][j])
+void compareLayouts(int N) {
+    timeval t1;
+    double sink = 0.0;
+
+    gettimeofday(&t1, NULL);
+    NestedMatrix nested(N, vector<float>(N, 0.1f));
+    double nestedInit = elapsedSince(t1);
+
+    gettimeofday(&t1, NULL);
+    for(int i = 0; i < N; i++)
+        for(int j = 0; j < N; j++)
+            sink += nested[i][j];
+    double nestedRows = elapsedSince(t1);
+
+    gettimeofday(&t1, NULL);
+    for(int j = 0; j < N; j++)
+        for(int i = 0; i < N; i++)
+            sink += nested[i][j];
+    double nestedCols = elapsedSince(t1);
+
+    gettimeofday(&t1, NULL);
+    Matrix flat(N, 0.1f);
+    double flatInit = elapsedSince(t1);
+
+    gettimeofday(&t1, NULL);
+    for(int i = 0; i < N; i++)
+        for(int j = 0; j < N; j++)
+            sink += flat[i][j];
+    double flatRows = elapsedSince(t1);
+
+    gettimeofday(&t1, NULL);
+    for(int j = 0; j < N; j++)
+        for(int i = 0; i < N; i++)
+            sink += flat[i][j];
+    double flatCols = elapsedSince(t1);
+
+    cout << "==== DISPOSICIÓN EN MEMORIA (N = " << N << ") ====\n";
+    cout << "vector<vector<float>>: " << nestedFootprint(N) / (1024.0 * 1024.0) << " MB en "
+         << N + 1 << " asignaciones; creación " << nestedInit << " s, por filas "
+         << nestedRows << " s, por columnas " << nestedCols << " s\n";
+    cout << "Matrix contigua:       " << flat.bytes() / (1024.0 * 1024.0) << " MB en 1 asignación"
+         << "; creación " << flatInit << " s, por filas " << flatRows << " s, por columnas "
+         << flatCols << " s\n";
+    cout << "(control: " << sink << ")\n\n";
+}
+
+// ---------------- MATRICES PEQUEÑAS DE TAMAÑO FIJO ----------------
+
+// C = A·B para matrices n x n densas (fila mayor, sin relleno) con n en
+// tiempo de ejecución: es el camino genérico contra el que se compara
+static void multiplySmall(const float *__restrict A, const float *__restrict B, float *__restrict C, int n) {
+    for(int i = 0; i < n; i++) {
+        float *c = C + (size_t)i * n;
+        for(int j = 0; j < n; j++) c[j] = 0.0f;
+        for(int k = 0; k < n; k++) {
+            float a = A[(size_t)i * n + k];
+            const float *b = B + (size_t)k * n;
+            for(int j = 0; j < n; j++) c[j] += a * b[j];
+        }
+    }
+}
+
+// Misma multiplicación con N conocido en compilación: los límites constantes
+// permiten al compilador desenrollar por completo y vectorizar sin bordes.
+// Con N = 16 se acumulan 4 filas de C en registros; con N mayor cada fila
+// de C cabe en L1 y se acumula directamente sobre ella.
+template <int N>
+inline void multiplyFixed(const float *__restrict A, const float *__restrict B, float *__restrict C) {
+    if constexpr (N <= 16) {
+        static_assert(N % 4 == 0, "N debe ser múltiplo de 4");
+        for(int i = 0; i < N; i += 4) {
+            float acc[4][N] = {};
+            for(int k = 0; k < N; k++) {
+                const float *b = B + k * N;
+                for(int r = 0; r < 4; r++) {
+                    float a = A[(i + r) * N + k];
+                    for(int j = 0; j < N; j++) acc[r][j] += a * b[j];
+                }
+            }
+            for(int r = 0; r < 4; r++)
+                for(int j = 0; j < N; j++) C[(i + r) * N + j] = acc[r][j];
+        }
+    } else {
+        for(int i = 0; i < N; i++) {
+            float *c = C + i * N;
+            for(int j = 0; j < N; j++) c[j] = 0.0f;
+            for(int k = 0; k < N; k++) {
+                float a = A[i * N + k];
+                const float *b = B + k * N;
+                for(int j = 0; j < N; j++) c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+using SmallKernel = void (*)(const float *, const float *, float *);
+
+// Núcleo especializado para n, o nullptr si n no tiene especialización
+SmallKernel fixedKernelFor(int n) {
+    switch(n) {
+        case 16: return multiplyFixed<16>;
+        case 32: return multiplyFixed<32>;
+        case 64: return multiplyFixed<64>;
+        case 128: return multiplyFixed<128>;
+        default: return nullptr;
+    }
+}
+
+// Multiplica count pares (A[b], B[b]) de matrices n x n guardados uno tras
+// otro en A, B y C, repartiendo lotes en el pool. Usa el núcleo de tamaño
+// fijo si existe para n (y useFixed es true) y el genérico en otro caso.
+void multiplySmallBatch(const float *A, const float *B, float *C, int n, size_t count,
+                        WorkStealingPool &pool, bool useFixed = true) {
+    SmallKernel fixedKernel = useFixed ? fixedKernelFor(n) : nullptr;
+    const size_t elems = (size_t)n * n;
+    const size_t perTask = max<size_t>(1, count / ((size_t)pool.size() * 8));
+    int tasks = (int)((count + perTask - 1) / perTask);
+
+    pool.run(tasks, [&](int t) {
+        size_t begin = (size_t)t * perTask;
+        size_t end = min(count, begin + perTask);
+        for(size_t b = begin; b < end; b++) {
+            if(fixedKernel)
+                fixedKernel(A + b * elems, B + b * elems, C + b * elems);
+            else
+                multiplySmall(A + b * elems, B + b * elems, C + b * elems, n);
+        }
+    });
+}
+
+// Compara el camino genérico con el especializado para n = 16, 32, 64, 128
+void benchmarkSmallMatrices(WorkStealingPool &pool) {
+    cout << "==== MATRICES PEQUEÑAS EN LOTE (" << pool.size() << " hilos) ====\n";
+    const size_t floatsPerOperand = (size_t)1 << 22;  // 16 MB por arreglo
+    const double targetFlops = 4e9;
+    const int sizes[] = {16, 32, 64, 128};
+
+    for(int n : sizes) {
+        size_t elems = (size_t)n * n;
+        size_t count = floatsPerOperand / elems;
+        vector<float> A(count * elems), B(count * elems), C(count * elems), Cref(count * elems);
+        for(size_t i = 0; i < A.size(); i++) {
+            A[i] = (float)(i % 7) * 0.1f;
+            B[i] = (float)(i % 5) * 0.2f;
+        }
+
+        double flopsPerBatch = 2.0 * n * n * (double)n * count;
+        int reps = max(1, (int)(targetFlops / flopsPerBatch));
+
+        timeval t1;
+        gettimeofday(&t1, NULL);
+        for(int r = 0; r < reps; r++)
+            multiplySmallBatch(A.data(), B.data(), Cref.data(), n, count, pool, false);
+        double timeGeneric = elapsedSince(t1);
+
+        gettimeofday(&t1, NULL);
+        for(int r = 0; r < reps; r++)
+            multiplySmallBatch(A.data(), B.data(), C.data(), n, count, pool, true);
+        double timeFixed = elapsedSince(t1);
+
+        double maxDiff = 0.0;
+        for(size_t i = 0; i < C.size(); i++)
+            maxDiff = max(maxDiff, (double)fabs(C[i] - Cref[i]));
+
+        cout << "n=" << setw(3) << n << "  lote=" << count << " x" << reps
+             << "  genérico: " << flopsPerBatch * reps / timeGeneric / 1e9 << " GFLOP/s"
+             << "  fijo: " << flopsPerBatch * reps / timeFixed / 1e9 << " GFLOP/s"
+             << " (" << count * reps / timeFixed / 1e6 << " M matrices/s)"
+             << "  speedup " << timeGeneric / timeFixed
+             << "  dif. máx " << scientific << maxDiff << fixed << "\n";
+    }
+    cout << "\n";
+}
+
+// ---------------- FUERA DE MEMORIA (OUT-OF-CORE) ----------------
+
+// Formato en disco por tiles: una cabecera de 4 KB y después los tiles de
+// tile x tile floats en orden de filas de tiles, cada uno contiguo (los de
+// borde se rellenan con ceros). Un tile entero se lee o escribe con un solo
+// pread/pwrite, sin saltos entre filas de la matriz.
+struct TiledHeader {
+    char magic[8];
+    int64_t n;
+    int64_t tile;
+};
+const size_t TILED_HEADER_BYTES = 4096;
+const char TILED_MAGIC[8] = {'E', 'J', '3', 'T', 'I', 'L', 'E', '1'};
+
+// Matriz N x N guardada en disco en formato por tiles. Solo se puede mover.
+class TiledMatrixFile {
+public:
+    TiledMatrixFile() = default;
+
+    // Crea (o trunca) path con el tamaño final; tile se redondea a múltiplo
+    // de 16 para que un tile en memoria sea una Matrix sin relleno
+    static TiledMatrixFile create(const string &path, int n, int tile) {
+        TiledMatrixFile f;
+        f.n = n;
+        f.tile = max(16, (tile + 15) / 16 * 16);
+        f.path = path;
+        f.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(f.fd < 0) throw runtime_error("no se pudo crear " + path + ": " + strerror(errno));
+
+        vector<char> header(TILED_HEADER_BYTES, 0);
+        TiledHeader h{};
+        memcpy(h.magic, TILED_MAGIC, sizeof h.magic);
+        h.n = n;
+        h.tile = f.tile;
+        memcpy(header.data(), &h, sizeof h);
+        f.transfer(header.data(), header.size(), 0, true);
+        if(ftruncate(f.fd, (off_t)f.fileBytes()) != 0)
+            throw runtime_error("no se pudo reservar " + path + ": " + strerror(errno));
+        return f;
+    }
+
+    TiledMatrixFile(TiledMatrixFile &&other) noexcept { *this = move(other); }
+    TiledMatrixFile &operator=(TiledMatrixFile &&other) noexcept {
+        swap(fd, other.fd);
+        swap(n, other.n);
+        swap(tile, other.tile);
+        swap(path, other.path);
+        return *this;
+    }
+    TiledMatrixFile(const TiledMatrixFile &) = delete;
+    TiledMatrixFile &operator=(const TiledMatrixFile &) = delete;
+
+    ~TiledMatrixFile() {
+        if(fd >= 0) close(fd);
+    }
+
+    int size() const { return n; }
+    int tileSize() const { return tile; }
+    int tilesPerSide() const { return (n + tile - 1) / tile; }
+    size_t tileBytes() const { return (size_t)tile * tile * sizeof(float); }
+    uint64_t fileBytes() const {
+        return TILED_HEADER_BYTES + (uint64_t)tilesPerSide() * tilesPerSide() * tileBytes();
+    }
+    const string &fileName() const { return path; }
+
+    // Lee / escribe el tile (ti, tj) completo desde / hacia out / in
+    void readTile(int ti, int tj, float *out) const { transfer(out, tileBytes(), tileOffset(ti, tj), false); }
+    void writeTile(int ti, int tj, const float *in) {
+        transfer(const_cast<float *>(in), tileBytes(), tileOffset(ti, tj), true);
+    }
+
+    // Baja a disco y descarta las páginas del caché del sistema, para que
+    // las lecturas siguientes midan el dispositivo y no la RAM
+    void dropCache() {
+        fdatasync(fd);
+#ifdef POSIX_FADV_DONTNEED
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    }
+
+private:
+    uint64_t tileOffset(int ti, int tj) const {
+        return TILED_HEADER_BYTES + ((uint64_t)ti * tilesPerSide() + tj) * tileBytes();
+    }
+
+    // pread/pwrite hasta completar bytes (pueden devolver menos de lo pedido)
+    void transfer(void *buffer, size_t bytes, uint64_t offset, bool write) const {
+        char *p = static_cast<char *>(buffer);
+        while(bytes > 0) {
+            ssize_t done = write ? pwrite(fd, p, bytes, (off_t)offset) : pread(fd, p, bytes, (off_t)offset);
+            if(done < 0 && errno == EINTR) continue;
+            if(done <= 0)
+                throw runtime_error(string(write ? "error de escritura en " : "error de lectura en ") + path +
+                                    (done < 0 ? string(": ") + strerror(errno) : string(": fin de archivo")));
+            p += done;
+            offset += (uint64_t)done;
+            bytes -= (size_t)done;
+        }
+    }
+
+    int fd = -1;
+    int n = 0;
+    int tile = 0;
+    string path;
+};
+
+// Escribe en f la matriz con elementos value(i, j). value es un parámetro
+// de plantilla para que se expanda en línea: con N = 32768 son 10^9 llamadas
+template <typename Value>
+void fillTiledMatrix(TiledMatrixFile &f, Value &&value) {
+    const int T = f.tileSize(), tiles = f.tilesPerSide(), N = f.size();
+    Matrix buffer(T);
+    for(int ti = 0; ti < tiles; ti++)
+        for(int tj = 0; tj < tiles; tj++) {
+            const int rows = min(T, N - ti * T), cols = min(T, N - tj * T);
+            for(int r = 0; r < T; r++) {
+                float *row = buffer[r];
+                const int i = ti * T + r;
+                int c = 0;
+                if(r < rows)
+                    for(; c < cols; c++) row[c] = value(i, tj * T + c);
+                for(; c < T; c++) row[c] = 0.0f;
+            }
+            f.writeTile(ti, tj, buffer[0]);
+        }
+}
+
+// Suma todos los elementos de una matriz en disco (el relleno es cero)
+double sumTiledMatrix(const TiledMatrixFile &f) {
+    const int T = f.tileSize(), tiles = f.tilesPerSide();
+    Matrix buffer(T);
+    double total = 0.0;
+    for(int ti = 0; ti < tiles; ti++)
+        for(int tj = 0; tj < tiles; tj++) {
+            f.readTile(ti, tj, buffer[0]);
+            for(int r = 0; r < T; r++)
+                for(int c = 0; c < T; c++)
+                    total += buffer[r][c];
+        }
+    return total;
+}
+
+struct OutOfCoreStats {
+    double seconds = 0.0;       // tiempo de pared total
+    double readSeconds = 0.0;   // tiempo del lector dentro de pread
+    double writeSeconds = 0.0;  // tiempo del escritor dentro de pwrite
+    double stallSeconds = 0.0;  // tiempo que el cómputo esperó tiles o buffers de C
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+};
+
+// C = A·B con las tres matrices en disco. Recorre los pasos (i, j, k) en ese
+// orden: C(i,j) se acumula en memoria sobre k y se escribe al terminar.
+//  - Un hilo lector trae A(i,k) y B(k,j) hasta prefetchDepth pasos por
+//    delante del cómputo, así la E/S se solapa con la multiplicación.
+//  - Un hilo escritor baja cada tile de C terminado mientras se calcula el
+//    siguiente (dos buffers de C alternados).
+//  - Cada paso se multiplica con multiplyTile repartiendo filas del tile en
+//    el pool.
+// Memoria: 2 * (prefetchDepth + 1) + 2 tiles, sin importar N. Cada paso hace
+// 2·T³ operaciones por 8·T² bytes leídos: con T = 1024 la E/S necesaria es
+// una fracción pequeña del cómputo.
+OutOfCoreStats multiplyOutOfCore(const TiledMatrixFile &A, const TiledMatrixFile &B, TiledMatrixFile &C,
+                                 WorkStealingPool &pool, int prefetchDepth = 2) {
+    using Clock = chrono::steady_clock;
+    const int T = A.tileSize(), tiles = A.tilesPerSide();
+    const long long steps = (long long)tiles * tiles * tiles;
+    const int depth = max(1, prefetchDepth) + 1;
+
+    struct Slot {
+        Matrix a, b;
+        bool ready = false;
+    };
+    vector<Slot> slots(depth);
+    for(auto &slot : slots) {
+        slot.a = Matrix(T);
+        slot.b = Matrix(T);
+    }
+    Matrix cTiles[2] = {Matrix(T), Matrix(T)};
+    bool cBusy[2] = {false, false};
+    struct WriteJob {
+        int ti, tj, buffer;
+    };
+    deque<WriteJob> writes;
+    bool noMoreWrites = false;
+    bool failed = false;
+    string error;
+    mutex m;
+    condition_variable changed;
+    OutOfCoreStats stats;
+
+    auto fail = [&](const exception &e) {
+        lock_guard<mutex> lock(m);
+        if(!failed) error = e.what();
+        failed = true;
+        changed.notify_all();
+    };
+
+    auto start = Clock::now();
+    thread reader([&]() {
+        for(long long s = 0; s < steps; s++) {
+            Slot &slot = slots[s % depth];
+            {
+                unique_lock<mutex> lock(m);
+                changed.wait(lock, [&]() { return !slot.ready || failed; });
+                if(failed) return;
+            }
+            int i = (int)(s / ((long long)tiles * tiles)), j = (int)(s / tiles % tiles), k = (int)(s % tiles);
+            auto t0 = Clock::now();
+            try {
+                A.readTile(i, k, slot.a[0]);
+                B.readTile(k, j, slot.b[0]);
+            } catch(const exception &e) {
+                fail(e);
+                return;
+            }
+            double dt = chrono::duration<double>(Clock::now() - t0).count();
+            lock_guard<mutex> lock(m);
+            stats.readSeconds += dt;
+            stats.bytesRead += 2 * A.tileBytes();
+            slot.ready = true;
+            changed.notify_all();
+        }
+    });
+    thread writer([&]() {
+        while(true) {
+            WriteJob job;
+            {
+                unique_lock<mutex> lock(m);
+                changed.wait(lock, [&]() { return !writes.empty() || noMoreWrites || failed; });
+                if(failed || writes.empty()) return;
+                job = writes.front();
+                writes.pop_front();
+            }
+            auto t0 = Clock::now();
+            try {
+                C.writeTile(job.ti, job.tj, cTiles[job.buffer][0]);
+            } catch(const exception &e) {
+                fail(e);
+                return;
+            }
+            double dt = chrono::duration<double>(Clock::now() - t0).count();
+            lock_guard<mutex> lock(m);
+            stats.writeSeconds += dt;
+            stats.bytesWritten += C.tileBytes();
+            cBusy[job.buffer] = false;
+            changed.notify_all();
+        }
+    });
+
+    int current = 0;
+    for(long long s = 0; s < steps; s++) {
+        int i = (int)(s / ((long long)tiles * tiles)), j = (int)(s / tiles % tiles), k = (int)(s % tiles);
+        Slot &slot = slots[s % depth];
+        {
+            auto t0 = Clock::now();
+            unique_lock<mutex> lock(m);
+            changed.wait(lock, [&]() { return (slot.ready && (k > 0 || !cBusy[current])) || failed; });
+            stats.stallSeconds += chrono::duration<double>(Clock::now() - t0).count();
+            if(failed) break;
+        }
+
+        Matrix &cTile = cTiles[current];
+        if(k == 0) memset(cTile[0], 0, cTile.bytes());
+        ConstMatrixView a = asConst(slot.a.view()), b = asConst(slot.b.view());
+        MatrixView c = cTile.view();
+        parallel_for(pool, 0, T, 64, [&](int lo, int hi) {
+            PerfScope scope("ej3/outOfCoreTile");
+            multiplyTile(a, b, c, lo, hi, 0, T);
+        });
+
+        {
+            lock_guard<mutex> lock(m);
+            slot.ready = false;
+            if(k == tiles - 1) {
+                cBusy[current] = true;
+                writes.push_back({i, j, current});
+            }
+        }
+        changed.notify_all();
+        if(k == tiles - 1) current ^= 1;
+    }
+
+    {
+        lock_guard<mutex> lock(m);
+        noMoreWrites = true;
+    }
+    changed.notify_all();
+    reader.join();
+    writer.join();
+    if(failed) throw runtime_error(error);
+
+    C.dropCache();
+    stats.seconds = chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+// Modo fuera de memoria (--ooc): para cada N crea A (0.1) y B (0.2) en disco
+// por tiles, multiplica con multiplyOutOfCore y muestra GFLOP/s y ancho de
+// banda de E/S. Verifica la suma de C contra 0.02·N³. Los archivos van en
+// --dir y se borran salvo con --keep.
+int runOutOfCore(const BenchArgs &args) {
+    vector<long long> sizes = args.has("n") ? vector<long long>{args.get_int("n", 8192)}
+                                            : args.get_list("sizes", {8192, 16384, 32768});
+    const int tile = (int)args.get_int("tile", 1024);
+    const int numThreads = (int)max<long long>(1, args.get_int("threads", max(1u, thread::hardware_concurrency())));
+    const int prefetch = (int)args.get_int("prefetch", 2);
+    const string dir = args.get("dir", ".");
+    WorkStealingPool &pool = WorkStealingPool::shared(numThreads);
+
+    cout << "==== MULTIPLICACIÓN FUERA DE MEMORIA (tiles de " << tile << ", " << numThreads
+         << " hilos, " << prefetch << " pasos de prelectura) ====\n";
+    cout << left << setw(8) << "N" << right << setw(12) << "seg" << setw(10) << "GFLOP/s"
+         << setw(12) << "E/S MB/s" << setw(12) << "lect.MB/s" << setw(12) << "escr.MB/s"
+         << setw(10) << "espera%" << setw(12) << "err.rel" << "\n";
+
+    for(long long size : sizes) {
+        const int N = (int)size;
+        const string prefix = dir + "/ej3_ooc_" + to_string(N);
+        try {
+            TiledMatrixFile A = TiledMatrixFile::create(prefix + "_A.tiles", N, tile);
+            TiledMatrixFile B = TiledMatrixFile::create(prefix + "_B.tiles", N, tile);
+            TiledMatrixFile C = TiledMatrixFile::create(prefix + "_C.tiles", N, tile);
+            fillTiledMatrix(A, [](int, int) { return 0.1f; });
+            fillTiledMatrix(B, [](int, int) { return 0.2f; });
+            A.dropCache();
+            B.dropCache();
+
+            OutOfCoreStats stats = multiplyOutOfCore(A, B, C, pool, prefetch);
+
+            double expected = 0.02 * (double)N * N * N;
+            double relError = fabs(sumTiledMatrix(C) - expected) / expected;
+            double mb = 1024.0 * 1024.0;
+            cout << fixed << setprecision(3) << left << setw(8) << N << right << setw(12) << stats.seconds
+                 << setprecision(2) << setw(10) << gflops(N, stats.seconds)
+                 << setw(12) << (stats.bytesRead + stats.bytesWritten) / mb / stats.seconds
+                 << setw(12) << (stats.readSeconds > 0 ? stats.bytesRead / mb / stats.readSeconds : 0.0)
+                 << setw(12) << (stats.writeSeconds > 0 ? stats.bytesWritten / mb / stats.writeSeconds : 0.0)
+                 << setw(10) << 100.0 * stats.stallSeconds / stats.seconds
+                 << setw(12) << scientific << setprecision(2) << relError << fixed << "\n";
+        } catch(const exception &e) {
+            cout << left << setw(8) << N << right << "  error: " << e.what() << "\n";
+        }
+        if(!args.has("keep"))
+            for(const char *name : {"_A.tiles", "_B.tiles", "_C.tiles"})
+                remove((prefix + name).c_str());
+    }
+    cout << "(E/S MB/s: bytes leídos y escritos por segundo de pared; lect./escr.: durante pread/pwrite)\n";
+    if(perf_regions_enabled()) perf_regions_report(cout);
+    return 0;
+}
+
 // Imprimir esquinas
 void printCorners(const Matrix &M, int N, const string &name) {
     cout << "Esquinas de " << name << ":\n";
@@ -75,17 +992,65 @@ void printCorners(const Matrix &M, int N, const string &name) {
     cout << M[N-1][0] << " ... " << M[N-1][N-1] << "\n\n";
 }
 
-int main() {
+// Barrido de hilos y tamaños de multiplyParallel con el arnés común (--bench)
+int runBenchmark(const BenchArgs &args) {
+    BenchReport report("ej3");
+    for(long long size : args.get_list("sizes", {256, 512, 1024})) {
+        int N = (int)size;
+        Matrix A = initMatrix(N, 0.1f);
+        Matrix B = initMatrix(N, 0.2f);
+        for(long long threads : args.threads()) {
+            report.run(args, "multiplyParallel", N, (int)threads, [&]() {
+                multiplyParallel(A, B, N, (int)threads);
+            });
+            report.run(args, "multiplyParallel_tiled", N, (int)threads, [&]() {
+                multiplyParallel(A, B, N, (int)threads, Kernel::Tiled);
+            });
+        }
+    }
+    report.print(args);
+    if(perf_regions_enabled()) perf_regions_report(cout);
+    return 0;
+}
+
+// Uso:
+//   ej3 [tileSize] [corteStrassen]                  pregunta N y la cantidad de hilos
+//   ej3 [tileSize] [corteStrassen] --n 1024 --threads 8   sin preguntas
+//       tileSize:      lado de los tiles 2D del planificador (128 por defecto)
+//       corteStrassen: por debajo de este N Strassen usa el núcleo por bloques (512 por defecto)
+//   ej3 --bench [--sizes 256,512] [--threads 1,2,4] [--reps 5] [--format csv|json]
+//   ej3 --ooc [--sizes 8192,16384,32768 | --n 8192] [--tile 1024] [--threads 8] [--prefetch 2] [--dir .] [--keep]
+//       multiplicación fuera de memoria con las matrices en disco por tiles
+//   --perf agrega contadores de hardware por región de los núcleos paralelos
+int main(int argc, char *argv[]) {
+    BenchArgs args(argc, argv);
+    if(args.has("perf")) perf_regions_enable();
+    if(args.has("bench")) return runBenchmark(args);
+    if(args.has("ooc")) return runOutOfCore(args);
+
     int N, numThreads;
-    cout << "Ingrese el tamaño N de la matriz: ";
-    cin >> N;
-    cout << "Ingrese la cantidad de hilos: ";
-    cin >> numThreads;
+    int tileSize = (args.positional.size() > 0) ? atoi(args.positional[0].c_str()) : 128;
+    int strassenCutoff = (args.positional.size() > 1) ? atoi(args.positional[1].c_str()) : 512;
+    if(args.has("n")) {
+        N = (int)args.get_int("n", 0);
+    } else {
+        cout << "Ingrese el tamaño N de la matriz: ";
+        cin >> N;
+    }
+    if(args.has("threads")) {
+        numThreads = (int)args.get_int("threads", 1);
+    } else {
+        cout << "Ingrese la cantidad de hilos: ";
+        cin >> numThreads;
+    }
+    numThreads = max(1, numThreads);
 
     // Inicializar matrices con los valores del enunciado
     Matrix A = initMatrix(N, 0.1f);
     Matrix B = initMatrix(N, 0.2f);
 
+    compareLayouts(N);
+
     // ---------------- SECUENCIAL ----------------
     timeval t1, t2;
     gettimeofday(&t1, NULL);
@@ -100,11 +1065,12 @@ int main() {
     cout << "\n==== Resultado SECUENCIAL ====\n";
     printCorners(C1, N, "Matriz C (secuencial)");
     cout << "Sumatoria: " << sumSeq << "\n";
-    cout << "Tiempo de ejecución: " << timeSeq << " segundos\n\n";
+    cout << "Tiempo de ejecución: " << timeSeq << " segundos"
+         << " (" << gflops(N, timeSeq) << " GFLOP/s)\n\n";
 
     // ---------------- PARALELO ----------------
     gettimeofday(&t1, NULL);
-    Matrix C2 = multiplyParallel(A, B, N, numThreads);
+    Matrix C2 = multiplyParallel(A, B, N, numThreads, Kernel::Naive, tileSize);
     gettimeofday(&t2, NULL);
 
     double timePar = double(t2.tv_sec - t1.tv_sec) +
@@ -115,12 +1081,69 @@ int main() {
     cout << "==== Resultado PARALELO ====\n";
     printCorners(C2, N, "Matriz C (paralela)");
     cout << "Sumatoria: " << sumPar << "\n";
-    cout << "Tiempo de ejecución: " << timePar << " segundos\n\n";
+    cout << "Tiempo de ejecución: " << timePar << " segundos"
+         << " (" << gflops(N, timePar) << " GFLOP/s)\n\n";
+
+    // ---------------- POR BLOQUES ----------------
+    gettimeofday(&t1, NULL);
+    Matrix C3 = multiplySequentialTiled(A, B, N);
+    gettimeofday(&t2, NULL);
+
+    double timeTiledSeq = double(t2.tv_sec - t1.tv_sec) +
+                          double(t2.tv_usec - t1.tv_usec) / 1000000.0;
+
+    gettimeofday(&t1, NULL);
+    Matrix C4 = multiplyParallel(A, B, N, numThreads, Kernel::Tiled, tileSize);
+    gettimeofday(&t2, NULL);
+
+    double timeTiledPar = double(t2.tv_sec - t1.tv_sec) +
+                          double(t2.tv_usec - t1.tv_usec) / 1000000.0;
+
+    cout << "==== Resultado POR BLOQUES (tiles 2D de " << tileSize << "x" << tileSize << ", robo de trabajo) ====\n";
+    printCorners(C4, N, "Matriz C (bloques, paralela)");
+    cout << "Sumatoria secuencial: " << sumMatrix(C3, N) << "\n";
+    cout << "Sumatoria paralela: " << sumMatrix(C4, N) << "\n";
+    cout << "Tiempo secuencial: " << timeTiledSeq << " segundos"
+         << " (" << gflops(N, timeTiledSeq) << " GFLOP/s)\n";
+    cout << "Tiempo paralelo: " << timeTiledPar << " segundos"
+         << " (" << gflops(N, timeTiledPar) << " GFLOP/s)\n";
+    cout << "Speedup vs bloques secuencial: " << timeTiledSeq / timeTiledPar
+         << " (eficiencia " << 100.0 * timeTiledSeq / timeTiledPar / numThreads << "%)\n\n";
+
+    WorkStealingPool &pool = WorkStealingPool::shared(numThreads);
+
+    // ---------------- STRASSEN-WINOGRAD ----------------
+    gettimeofday(&t1, NULL);
+    Matrix C5 = multiplyStrassen(A, B, N, pool, strassenCutoff);
+    gettimeofday(&t2, NULL);
+
+    double timeStrassen = double(t2.tv_sec - t1.tv_sec) +
+                          double(t2.tv_usec - t1.tv_usec) / 1000000.0;
+
+    double sumStrassen = sumMatrix(C5, N);
+    cout << "==== Resultado STRASSEN-WINOGRAD (corte " << strassenCutoff << ") ====\n";
+    printCorners(C5, N, "Matriz C (Strassen)");
+    cout << "Sumatoria: " << sumStrassen << "\n";
+    cout << "Error relativo vs secuencial: "
+         << scientific << (sumSeq != 0.0 ? fabs(sumStrassen - sumSeq) / fabs(sumSeq) : fabs(sumStrassen))
+         << fixed << "\n";
+    cout << "Tiempo de ejecución: " << timeStrassen << " segundos"
+         << " (" << gflops(N, timeStrassen) << " GFLOP/s equivalentes)\n";
+    cout << "Speedup vs secuencial: " << timeSeq / timeStrassen
+         << ", vs bloques secuencial: " << timeTiledSeq / timeStrassen << "\n\n";
+
+    // ---------------- MATRICES PEQUEÑAS ----------------
+    benchmarkSmallMatrices(pool);
 
     // ---------------- SPEEDUP ----------------
     cout << "==== SPEEDUP ====\n";
     cout << "Speedup = TiempoSecuencial / TiempoParalelo = "
          << timeSeq / timePar << "\n";
+    cout << "Speedup bloques = TiempoSecuencial / TiempoBloquesParalelo = "
+         << timeSeq / timeTiledPar << "\n";
+
+    // Contadores de hardware de los núcleos paralelos (--perf)
+    if(perf_regions_enabled()) perf_regions_report(cout);
 
     return 0;
 }
@@ -6,9 +6,26 @@
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <thread>
 #include <vector>
 #include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "bench.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PRIME_CACHE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using Clock = std::chrono::high_resolution_clock;
 using Ms    = std::chrono::duration<double, std::milli>;
@@ -41,6 +58,7 @@ static std::vector<int> build_base_primes(long long limit) {
 static PrimeSummary count_primes_sequential(long long N) {
     PrimeSummary out;
     if (N <= 2) return out;
+    PerfScope scope("ej4/sequential");
 
     std::vector<unsigned char> is_prime((size_t)N, 1);
     is_prime[0] = 0;
@@ -59,12 +77,28 @@ static PrimeSummary count_primes_sequential(long long N) {
     return out;
 }
 
-// Longitud de bloque en función del progreso (crece con la posición)
-// Block length as a function of progress (grows with position)
-static inline long long choose_block_len(long long lo, long long end, long long total) {
-    const long long MIN_TILE = 1LL << 18;  // 262,144
-    const long long MAX_TILE = 1LL << 21;  // 2,097,152
-    double f = (total > 0) ? double(lo - 2) / double(total) : 0.0;
+// Tamaño de la caché de datos de nivel 1 o 2 en bytes (o el valor por defecto)
+// Size in bytes of the level 1 or 2 data cache (or the default)
+static long long data_cache_bytes(int level, long long fallback) {
+    long v = -1;
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+    v = sysconf(level == 1 ? _SC_LEVEL1_DCACHE_SIZE : _SC_LEVEL2_CACHE_SIZE);
+#else
+    (void)level;
+#endif
+    return v > 0 ? (long long)v : fallback;
+}
+
+// Longitud de bloque en función del progreso (crece con la posición).
+// Con un bit por impar un segmento de len enteros ocupa len/16 bytes:
+// el mínimo llena L1 y el máximo la mitad de L2.
+// Block length as a function of progress (grows with position).
+// With one bit per odd number a segment of len integers takes len/16 bytes:
+// the minimum fills L1 and the maximum half of L2.
+static inline long long choose_block_len(long long lo, long long begin, long long end, long long total) {
+    static const long long MIN_TILE = 16 * data_cache_bytes(1, 32 * 1024);
+    static const long long MAX_TILE = std::max(MIN_TILE, 8 * data_cache_bytes(2, 256 * 1024));
+    double f = (total > 0) ? double(lo - begin) / double(total) : 0.0;
     long long len = (long long)std::llround(MIN_TILE + (MAX_TILE - MIN_TILE) * f);
     if (len < MIN_TILE) len = MIN_TILE;
     if (len > MAX_TILE) len = MAX_TILE;
@@ -72,15 +106,25 @@ static inline long long choose_block_len(long long lo, long long end, long long
     return std::max(0LL, len);
 }
 
-// Reclama el siguiente segmento [lo, hi] desde un cursor atómico
-// Claim next [lo, hi] segment from an atomic cursor
-static bool next_segment(std::atomic<long long>& cursor, long long end, long long total,
-                         long long& lo, long long& hi) {
+// Segmentos consecutivos que se reclaman juntos: dentro de un reclamo el
+// hilo reutiliza los cursores de múltiplos sin volver a dividir
+// Consecutive segments claimed together: inside a claim the thread reuses
+// the multiple cursors without dividing again
+static const long long SEGMENTS_PER_CLAIM = 8;
+
+// Reclama el siguiente bloque [lo, hi] desde un cursor atómico. Si align > 0
+// el bloque no cruza ningún múltiplo de align.
+// Claim next [lo, hi] block from an atomic cursor. If align > 0 the block
+// never crosses a multiple of align.
+static bool next_segment(std::atomic<long long>& cursor, long long begin, long long end, long long total,
+                         long long align, long long& lo, long long& hi) {
     while (true) {
         long long cur = cursor.load(std::memory_order_relaxed);
         if (cur > end) return false;
-        long long len = choose_block_len(cur, end, total);
+        long long len = choose_block_len(cur, begin, end, total) * SEGMENTS_PER_CLAIM;
         if (len <= 0) return false;
+        if (cur + len - 1 > end) len = end - cur + 1;
+        if (align > 0) len = std::min(len, (cur / align + 1) * align - cur);
         long long nx = cur + len;
         if (cursor.compare_exchange_weak(cur, nx, std::memory_order_acq_rel, std::memory_order_relaxed)) {
             lo = cur;
@@ -90,73 +134,349 @@ static bool next_segment(std::atomic<long long>& cursor, long long end, long lon
     }
 }
 
-// Criba segmentada de [lo, hi] usando los primos base
-// Segmented sieve over [lo, hi] using base primes
+// Entrada de un cubo de la criba por cubos: primo base y bit a tachar
+// dentro del segmento al que pertenece el cubo
+// Bucket sieve entry: base prime and bit to clear inside the bucket's segment
+struct BucketEntry {
+    uint32_t prime_index;
+    uint32_t bit;
+};
+
+// Primo base grande cuyo próximo múltiplo impar (absoluto) cae después del
+// último reclamo; pasa a los cubos del siguiente reclamo contiguo
+// Large base prime whose next odd multiple (absolute) lies past the last
+// claim; it moves into the buckets of the next contiguous claim
+struct PendingPrime {
+    uint32_t prime_index;
+    long long next;
+};
+
+// Estado persistente de cada hilo: el buffer de bits del segmento se reserva
+// una vez y se reutiliza, y next_multiple guarda para cada primo base el
+// próximo múltiplo impar a tachar. Si el segmento siguiente empieza justo
+// después del anterior (next_lo) los cursores siguen valiendo y se evita la
+// división por cada primo.
+// Per-thread persistent state: the segment bit buffer is reserved once and
+// reused, and next_multiple holds the next odd multiple to cross off for
+// each base prime. When the next segment starts right after the previous one
+// (next_lo) the cursors are still valid and the per-prime division is skipped.
+struct SieveWorkspace {
+    std::vector<uint64_t> bits;
+    std::vector<long long> next_multiple;
+    size_t cursor_count = 0;  // primos con cursor válido / primes with a valid cursor
+    long long next_lo = -1;
+    std::vector<std::vector<BucketEntry>> buckets;  // un cubo por segmento del bloque
+    std::vector<PendingPrime> pending, carried;     // primos grandes pendientes / pending large primes
+    size_t pending_begin = 0, pending_end = 0;      // primos base [begin, end) seguidos en pending
+    long long pending_lo = -1;                      // pending vale si el reclamo empieza acá
+};
+
+// Modo de criba para los primos base grandes
+// Sieving mode for large base primes
+enum class SieveMode {
+    Classic,  // todos los primos base recorren cada segmento / every base prime visits every segment
+    Bucket,   // los primos mayores que un segmento van a cubos / primes larger than a segment go to buckets
+    Auto      // cubos solo si hay primos base mayores que un segmento / buckets only if needed
+};
+
+// Criba segmentada de [lo, hi] usando los primos base.
+// Solo se guardan los impares, un bit por candidato: el bit i corresponde a
+// first_odd + 2*i. El 2 se cuenta aparte y el conteo usa popcount por palabra.
+// Segmented sieve over [lo, hi] using base primes.
+// Only odd numbers are stored, one bit each: bit i maps to first_odd + 2*i.
+// 2 is handled separately and counting uses a per-word popcount.
+// Solo se recorren los primeros small_end primos base; si se pasa un cubo,
+// sus entradas (primos grandes que caen en este segmento) también se tachan.
+// Only the first small_end base primes are walked; if a bucket is given,
+// its entries (large primes hitting this segment) are cleared as well.
 static void sieve_segment(long long lo, long long hi,
                           const std::vector<int>& base,
+                          SieveWorkspace& ws,
                           unsigned long long& count_out,
-                          std::vector<long long>& tail_out) {
-    const size_t L = (size_t)(hi - lo + 1);
-    std::vector<unsigned char> seg(L, 1);
+                          std::vector<long long>& tail_out,
+                          size_t small_end = SIZE_MAX,
+                          const std::vector<BucketEntry>* bucket = nullptr) {
+    count_out = 0;
+    if (hi < lo) return;
+    small_end = std::min(small_end, base.size());
+
+    // Cursores válidos solo si este segmento continúa al anterior
+    // Cursors are valid only if this segment continues the previous one
+    if (ws.next_lo != lo || ws.cursor_count < small_end) {
+        ws.next_multiple.resize(base.size());
+        ws.cursor_count = small_end;
+        for (size_t k = 0; k < small_end; ++k) {
+            long long p  = base[k];
+            long long pp = p * p;
+            long long start = (pp > lo) ? pp : ((lo + p - 1) / p) * p;
+            if ((start & 1) == 0) start += p;
+            ws.next_multiple[k] = start;
+        }
+    } else {
+        // Este segmento solo avanza los primeros small_end cursores; los
+        // demás quedan atrasados y el próximo segmento debe recalcularlos
+        // This segment only advances the first small_end cursors; the rest
+        // fall behind and the next segment must recompute them
+        ws.cursor_count = small_end;
+    }
+    ws.next_lo = hi + 1;
+
+    const bool has_two = (lo <= 2 && 2 <= hi);
+    const long long first_odd = lo | 1;
+    if (first_odd > hi) {
+        if (has_two) { count_out = 1; tail_out.push_back(2); }
+        return;
+    }
 
-    if (lo == 0) seg[0] = 0;
-    if (lo <= 1 && 1 <= hi) seg[(size_t)(1 - lo)] = 0;
+    const size_t bits  = (size_t)((hi - first_odd) / 2 + 1);
+    const size_t words = (bits + 63) / 64;
+    std::vector<uint64_t>& seg = ws.bits;
+    seg.assign(words, ~0ULL);
+    if (bits % 64) seg[words - 1] = (1ULL << (bits % 64)) - 1;
+    if (first_odd == 1) seg[0] &= ~1ULL;
+
+    for (size_t k = 0; k < small_end; ++k) {
+        long long p = base[k];
+        if (p == 2) continue;
+        long long start = ws.next_multiple[k];
+        if (start > hi) {
+            if (1LL * p * p > hi) break;  // este y los siguientes aún no empiezan
+            continue;
+        }
+        size_t i = (size_t)((start - first_odd) / 2);
+        for (; i < bits; i += (size_t)p)
+            seg[i >> 6] &= ~(1ULL << (i & 63));
+        ws.next_multiple[k] = first_odd + 2 * (long long)i;
+    }
 
-    for (int p : base) {
-        long long pp = 1LL * p * p;
-        if (pp > hi) break;
-        long long start = std::max(pp, ((lo + p - 1) / (long long)p) * (long long)p);
-        for (long long j = start; j <= hi; j += p) seg[(size_t)(j - lo)] = 0;
+    if (bucket) {
+        for (const BucketEntry& e : *bucket)
+            seg[e.bit >> 6] &= ~(1ULL << (e.bit & 63));
     }
 
-    unsigned long long cnt = 0;
-    for (size_t i = 0; i < L; ++i) if (seg[i]) ++cnt;
+    unsigned long long cnt = has_two ? 1 : 0;
+    for (size_t w = 0; w < words; ++w) cnt += (unsigned long long)__builtin_popcountll(seg[w]);
     count_out = cnt;
 
-    for (long long j = hi; j >= lo && (int)tail_out.size() < 10; --j) {
-        if (seg[(size_t)(j - lo)]) tail_out.push_back(j);
+    for (size_t w = words; w-- > 0 && (int)tail_out.size() < 10;) {
+        uint64_t word = seg[w];
+        while (word && (int)tail_out.size() < 10) {
+            int b = 63 - __builtin_clzll(word);
+            tail_out.push_back(first_odd + 2 * (long long)(w * 64 + (size_t)b));
+            word &= ~(1ULL << b);
+        }
     }
+    if (has_two && (int)tail_out.size() < 10) tail_out.push_back(2);
 }
 
-// Paralelo con “cola” dinámica de segmentos y bloques de tamaño variable
-// Parallel with dynamic segment queue and variable block sizes
-static PrimeSummary count_primes_parallel_dynamic(long long N, int threads) {
+// Criba un bloque reclamado [lo, hi] en segmentos de seg_len y acumula en
+// count_out / top_out. En modo cubos, los primos base con paso (en bits)
+// mayor o igual que un segmento tocan cada segmento a lo sumo una vez: se
+// colocan en el cubo del segmento de su próximo múltiplo y, al procesarlo,
+// pasan al cubo del siguiente. Cada segmento solo ve los primos que lo cruzan.
+// Los que se pasan de hi quedan pendientes en ws para el próximo reclamo.
+// Sieves a claimed block [lo, hi] in seg_len segments, accumulating into
+// count_out / top_out. In bucket mode, base primes whose step (in bits) is at
+// least a segment hit each segment at most once: they sit in the bucket of
+// the segment holding their next multiple and move on to the next one once
+// processed. Each segment only sees the primes that actually cross it.
+// Those past hi stay pending in ws for the next claim.
+static void sieve_block(long long lo, long long hi, long long seg_len,
+                        const std::vector<int>& base, bool use_buckets,
+                        SieveWorkspace& ws, unsigned long long& count_out,
+                        std::vector<long long>& top_out, std::vector<long long>& t) {
+    size_t small_end = base.size();
+    size_t segments = (size_t)((hi - lo) / seg_len + 1);
+
+    if (use_buckets) {
+        // Un segmento tiene como mucho seg_len/2 + 1 impares
+        // A segment holds at most seg_len/2 + 1 odd numbers
+        const long long max_bits = seg_len / 2 + 1;
+        small_end = (size_t)(std::lower_bound(base.begin(), base.end(), (int)std::min<long long>(max_bits, INT_MAX))
+                             - base.begin());
+        if (ws.buckets.size() < segments) ws.buckets.resize(segments);
+
+        auto place = [&](size_t k, long long next) {
+            if (next > hi) {
+                ws.pending.push_back({(uint32_t)k, next});
+                return;
+            }
+            size_t j = (size_t)((next - lo) / seg_len);
+            long long seg_first_odd = (lo + (long long)j * seg_len) | 1;
+            ws.buckets[j].push_back({(uint32_t)k, (uint32_t)((next - seg_first_odd) / 2)});
+        };
+
+        // Si el reclamo sigue al anterior del hilo, los primos pendientes ya
+        // traen su próximo múltiplo y no hace falta dividir; los que ahora
+        // caen por debajo de small_end quedan a cargo de los cursores
+        // If the claim follows the thread's previous one, pending primes
+        // already carry their next multiple and no division is needed; those
+        // now below small_end are left to the cursors
+        const bool carry = (ws.pending_lo == lo);
+        ws.carried.swap(ws.pending);
+        ws.pending.clear();
+        if (carry) {
+            for (const PendingPrime& pp : ws.carried)
+                if (pp.prime_index >= small_end) place(pp.prime_index, pp.next);
+        }
+
+        size_t started = base.size();  // primer primo cuyo cuadrado pasa hi / first prime whose square exceeds hi
+        for (size_t k = small_end; k < base.size(); ++k) {
+            if (carry && k >= ws.pending_begin && k < ws.pending_end) {
+                k = ws.pending_end - 1;
+                continue;
+            }
+            long long p  = base[k];
+            if (p == 2) continue;  // solo se guardan impares / only odd numbers are stored
+            long long pp = p * p;
+            if (pp > hi) {
+                started = k;
+                break;
+            }
+            long long start = (pp > lo) ? pp : ((lo + p - 1) / p) * p;
+            if ((start & 1) == 0) start += p;
+            place(k, start);
+        }
+        ws.pending_begin = small_end;
+        ws.pending_end = started;
+        ws.pending_lo = hi + 1;
+    }
+
+    for (size_t j = 0; j < segments; ++j) {
+        long long s  = lo + (long long)j * seg_len;
+        long long e  = std::min(hi, s + seg_len - 1);
+        unsigned long long c = 0;
+        t.clear();
+        sieve_segment(s, e, base, ws, c, t, small_end, use_buckets ? &ws.buckets[j] : nullptr);
+        count_out += c;
+
+        // Los segmentos de un hilo van en orden creciente: los primos
+        // nuevos preceden a los ya guardados y se conservan 10
+        // A thread's segments ascend: new primes go before the kept
+        // ones and only 10 are retained
+        if (!t.empty()) {
+            t.insert(t.end(), top_out.begin(), top_out.end());
+            if (t.size() > 10) t.resize(10);
+            top_out.swap(t);
+        }
+
+        if (use_buckets) {
+            // Cada primo del cubo pasa al cubo de su siguiente múltiplo impar
+            // Every prime in the bucket moves to the bucket of its next odd multiple
+            long long first_odd = s | 1;
+            for (const BucketEntry& be : ws.buckets[j]) {
+                long long p = base[be.prime_index];
+                long long next = first_odd + 2 * (long long)be.bit + 2 * p;
+                if (next > hi) {
+                    ws.pending.push_back({be.prime_index, next});
+                    continue;
+                }
+                size_t nj = (size_t)((next - lo) / seg_len);
+                long long next_first_odd = (lo + (long long)nj * seg_len) | 1;
+                ws.buckets[nj].push_back({be.prime_index, (uint32_t)((next - next_first_odd) / 2)});
+            }
+            ws.buckets[j].clear();
+        }
+    }
+}
+
+// Agrega los primos de "newer" (todos mayores, desc) delante de "kept" (desc)
+// y conserva los 10 mayores
+// Puts the primes in "newer" (all larger, desc) before "kept" (desc) and
+// keeps the 10 largest
+static void prepend_top10(std::vector<long long>& kept, const std::vector<long long>& newer) {
+    if (newer.empty()) return;
+    std::vector<long long> merged(newer);
+    merged.insert(merged.end(), kept.begin(), kept.end());
+    if (merged.size() > 10) merged.resize(10);
+    kept.swap(merged);
+}
+
+// Cuenta los primos de [lo, hi] en paralelo con “cola” dinámica de bloques.
+// Si per_block no es nulo, también acumula cantidad y top 10 por cada bloque
+// alineado de block_size enteros: per_block[i] cubre
+// [(lo / block_size + i) * block_size, ... + block_size).
+// Counts primes in [lo, hi] in parallel with a dynamic block queue.
+// If per_block is not null, it also accumulates count and top 10 for each
+// aligned block of block_size integers.
+static PrimeSummary count_primes_range(long long lo, long long hi, int threads,
+                                       SieveMode mode = SieveMode::Auto,
+                                       long long block_size = 0,
+                                       std::vector<PrimeSummary>* per_block = nullptr) {
     PrimeSummary out;
-    if (N <= 2) return out;
+    const long long BEGIN = std::max(2LL, lo);
+    const long long END   = hi;
+    if (END < BEGIN) return out;
+    const long long TOTAL = END - BEGIN + 1;
 
     threads = std::max(1, threads);
-    std::vector<int> base = build_base_primes((long long)std::floor(std::sqrt((long double)N)));
+    std::vector<int> base;
+    {
+        PerfScope scope("ej4/base_primes");
+        base = build_base_primes((long long)std::floor(std::sqrt((long double)END)));
+    }
 
-    const long long BEGIN = 2;
-    const long long END   = N - 1;
-    const long long TOTAL = std::max(0LL, END - BEGIN + 1);
+    // En modo automático se usan cubos si algún primo base supera el
+    // segmento más chico (medido en bits, un bit por impar)
+    // In auto mode buckets are used if some base prime exceeds the smallest
+    // segment (measured in bits, one bit per odd number)
+    const bool use_buckets = (mode == SieveMode::Bucket) ||
+        (mode == SieveMode::Auto && !base.empty() && base.back() >= choose_block_len(BEGIN, BEGIN, END, TOTAL) / 2);
+
+    const long long align = per_block ? block_size : 0;
+    const long long first_block = per_block ? lo / block_size : 0;
 
     std::atomic<long long> cursor(BEGIN);
-    std::vector<std::thread> pool;
+    std::mutex block_mutex;
     std::vector<unsigned long long> counts(threads, 0);
     std::vector<std::vector<long long>> tails(threads);
 
     auto worker = [&](int tid) {
         unsigned long long local_count = 0;
         std::vector<long long> local_tails;
-        local_tails.reserve(256);
-
-        long long lo, hi;
-        while (next_segment(cursor, END, TOTAL, lo, hi)) {
-            unsigned long long c = 0;
-            std::vector<long long> t;
-            sieve_segment(lo, hi, base, c, t);
-            local_count += c;
-            local_tails.insert(local_tails.end(), t.begin(), t.end());
+        local_tails.reserve(20);
+
+        // Buffer y cursores propios del hilo, reutilizados en cada segmento
+        // Thread-owned buffer and cursors, reused for every segment
+        SieveWorkspace ws;
+        ws.bits.reserve((size_t)(choose_block_len(END, BEGIN, LLONG_MAX, TOTAL) / 128 + 1));
+        std::vector<long long> t, claim_top;
+        t.reserve(20);
+        claim_top.reserve(20);
+
+        long long a, b;
+        while (next_segment(cursor, BEGIN, END, TOTAL, align, a, b)) {
+            // El bloque reclamado se criba en segmentos consecutivos del tamaño de caché
+            // The claimed block is sieved as consecutive cache-sized segments
+            long long seg_len = choose_block_len(a, BEGIN, b, TOTAL);
+            unsigned long long claim_count = 0;
+            claim_top.clear();
+            {
+                PerfScope scope("ej4/segment_sieve");
+                sieve_block(a, b, seg_len, base, use_buckets, ws, claim_count, claim_top, t);
+            }
+
+            local_count += claim_count;
+            prepend_top10(local_tails, claim_top);
+
+            if (per_block) {
+                std::lock_guard<std::mutex> lock(block_mutex);
+                PrimeSummary& blk = (*per_block)[(size_t)(a / block_size - first_block)];
+                blk.total += claim_count;
+                blk.top10_desc.insert(blk.top10_desc.end(), claim_top.begin(), claim_top.end());
+                std::sort(blk.top10_desc.begin(), blk.top10_desc.end(), std::greater<long long>());
+                if (blk.top10_desc.size() > 10) blk.top10_desc.resize(10);
+            }
         }
         counts[tid] = local_count;
         tails[tid]  = std::move(local_tails);
     };
 
-    pool.reserve(threads);
-    for (int t = 0; t < threads; ++t) pool.emplace_back(worker, t);
-    for (auto& th : pool) th.join();
+    if (per_block) per_block->assign((size_t)(END / block_size - first_block + 1), PrimeSummary());
 
+    WorkStealingPool::shared(threads).run(threads, worker);
+
+    PerfScope scope("ej4/merge");
     for (auto c : counts) out.total += c;
 
     std::vector<long long> merged;
@@ -167,6 +487,322 @@ static PrimeSummary count_primes_parallel_dynamic(long long N, int threads) {
     return out;
 }
 
+// Compara la criba por cubos con la clásica en 4 bloques alineados cerca de
+// around. El bloque mide un reclamo inicial más 4096: cada bloque queda en
+// un reclamo normal, uno corto (segmentos más cortos, otro small_end) y el
+// siguiente bloque sigue de forma contigua con los cursores del hilo. Con
+// un solo hilo el orden de los reclamos es fijo.
+// Compares the bucket sieve with the classic one over 4 aligned blocks near
+// around. A block is one initial claim plus 4096: each block becomes a
+// normal claim and a short one (shorter segments, another small_end), and
+// the next block continues contiguously with the thread's cursors. With a
+// single thread the claim order is fixed.
+static bool bucket_matches_classic(long long around) {
+    const long long block = choose_block_len(0, 0, LLONG_MAX, LLONG_MAX) * SEGMENTS_PER_CLAIM + 4096;
+    const long long lo = std::max(1LL, around / block) * block;
+    const long long hi = lo + 4 * block - 1;
+    std::vector<PrimeSummary> bucket_blocks, classic_blocks;
+    PrimeSummary bucket = count_primes_range(lo, hi, 1, SieveMode::Bucket, block, &bucket_blocks);
+    PrimeSummary classic = count_primes_range(lo, hi, 1, SieveMode::Classic, block, &classic_blocks);
+    if (bucket.total != classic.total || bucket.top10_desc != classic.top10_desc) return false;
+    for (size_t i = 0; i < bucket_blocks.size(); ++i)
+        if (bucket_blocks[i].total != classic_blocks[i].total) return false;
+    return true;
+}
+
+// Paralelo con “cola” dinámica de segmentos y bloques de tamaño variable
+// Parallel with dynamic segment queue and variable block sizes
+static PrimeSummary count_primes_parallel_dynamic(long long N, int threads,
+                                                  SieveMode mode = SieveMode::Auto) {
+    if (N <= 2) return PrimeSummary();
+    return count_primes_range(2, N - 1, threads, mode);
+}
+
+// Raíz cuadrada entera exacta
+// Exact integer square root
+static long long isqrt_ll(long long n) {
+    long long r = (long long)std::sqrt((long double)n);
+    while (r * r > n) --r;
+    while ((r + 1) * (r + 1) <= n) ++r;
+    return r;
+}
+
+// π(n) = cantidad de primos <= n con el método de Lucy_Hedgehog, O(n^(3/4)).
+// S(v) arranca en v - 1 y, para cada primo p <= sqrt(n), a todo v >= p²
+// se le resta S(v/p) - S(p-1). Solo hacen falta los valores v = n/i y
+// v <= sqrt(n): small[v] = S(v), large[i] = S(n/i). Para cada p las
+// diferencias se calculan primero (en paralelo, leyendo valores viejos) y
+// luego se aplican (en paralelo), así el orden entre hilos no importa.
+// π(n) = count of primes <= n with Lucy_Hedgehog's method, O(n^(3/4)).
+// S(v) starts as v - 1 and, for each prime p <= sqrt(n), every v >= p² gets
+// S(v/p) - S(p-1) subtracted. Only v = n/i and v <= sqrt(n) are needed:
+// small[v] = S(v), large[i] = S(n/i). For each p the differences are first
+// computed (in parallel, reading old values) and then applied (in parallel),
+// so thread ordering does not matter.
+static unsigned long long prime_pi_lucy(long long n, int threads) {
+    if (n < 2) return 0;
+    PerfScope scope("ej4/lucy");
+    const long long r = isqrt_ll(n);
+    std::vector<long long> small((size_t)r + 1), large((size_t)r + 1), delta;
+    WorkStealingPool& pool = WorkStealingPool::shared(threads);
+    const long long GRAIN = 1LL << 13;
+    for (long long v = 1; v <= r; ++v) small[(size_t)v] = v - 1;
+    for (long long i = 1; i <= r; ++i) large[(size_t)i] = n / i - 1;
+
+    for (long long p = 2; p <= r; ++p) {
+        if (small[(size_t)p] == small[(size_t)p - 1]) continue;  // p no es primo / p is not prime
+        const long long sp = small[(size_t)p - 1];
+        const long long p2 = p * p;
+        const long long large_count = std::min(r, n / p2);          // i con n/i >= p²
+        const long long small_count = (r >= p2) ? r - p2 + 1 : 0;   // v en [p², r]
+        const long long total = large_count + small_count;
+        delta.resize((size_t)total);
+
+        parallel_for(pool, 0LL, total, GRAIN, [&](long long a, long long b) {
+            for (long long idx = a; idx < b; ++idx) {
+                if (idx < large_count) {
+                    long long ip = (idx + 1) * p;
+                    long long s_div = (ip <= r) ? large[(size_t)ip] : small[(size_t)(n / ip)];
+                    delta[(size_t)idx] = s_div - sp;
+                } else {
+                    long long v = p2 + (idx - large_count);
+                    delta[(size_t)idx] = small[(size_t)(v / p)] - sp;
+                }
+            }
+        });
+        parallel_for(pool, 0LL, total, GRAIN, [&](long long a, long long b) {
+            for (long long idx = a; idx < b; ++idx) {
+                if (idx < large_count) large[(size_t)idx + 1] -= delta[(size_t)idx];
+                else small[(size_t)(p2 + idx - large_count)] -= delta[(size_t)idx];
+            }
+        });
+    }
+    return (unsigned long long)large[1];
+}
+
+// Modo combinatorio: π(N-1) con Lucy_Hedgehog y el top 10 con una criba
+// segmentada de ventanas crecientes justo por debajo de N
+// Combinatorial mode: π(N-1) with Lucy_Hedgehog and the top 10 from a
+// segmented sieve over growing windows just below N
+static PrimeSummary count_primes_lucy(long long N, int threads) {
+    PrimeSummary out;
+    if (N <= 2) return out;
+    out.total = prime_pi_lucy(N - 1, threads);
+
+    std::vector<int> base = build_base_primes(isqrt_ll(N - 1));
+    SieveWorkspace ws;
+    std::vector<long long> t;
+    long long hi = N - 1;
+    long long window = 1LL << 12;
+    while ((int)out.top10_desc.size() < 10 && hi >= 2) {
+        long long lo = std::max(2LL, hi - window + 1);
+        unsigned long long c = 0;
+        t.clear();
+        sieve_segment(lo, hi, base, ws, c, t);
+        for (long long p : t) {
+            if ((int)out.top10_desc.size() == 10) break;
+            out.top10_desc.push_back(p);
+        }
+        hi = lo - 1;
+        window *= 2;
+    }
+    return out;
+}
+
+// Caché persistente de puntos de control.
+// Formato del archivo: cabecera {magic, block_size} y luego una entrada por
+// bloque b con la cantidad de primos < (b+1)*block_size y los 10 mayores
+// primos por debajo de ese límite (0 si hay menos). Solo se agregan entradas
+// al final; una entrada incompleta (escritura interrumpida) se descarta.
+// Persistent checkpoint cache.
+// File layout: header {magic, block_size} followed by one entry per block b
+// holding the count of primes < (b+1)*block_size and the 10 largest primes
+// below that boundary (0 if fewer). Entries are only appended; a partial
+// trailing entry (interrupted write) is discarded.
+static const long long CHECKPOINT_BLOCK = 1LL << 24;
+static const char CHECKPOINT_MAGIC[8] = {'E', 'J', '4', 'P', 'R', 'I', 'M', '1'};
+
+struct CheckpointHeader {
+    char magic[8];
+    long long block_size;
+};
+
+struct CheckpointEntry {
+    unsigned long long count;
+    long long top10[10];
+};
+
+class PrimeCheckpointCache {
+public:
+    PrimeCheckpointCache(const std::string& path, long long block_size)
+        : path_(path), block_size_(block_size) {
+        load();
+    }
+
+    ~PrimeCheckpointCache() { unload(); }
+
+    PrimeCheckpointCache(const PrimeCheckpointCache&) = delete;
+    PrimeCheckpointCache& operator=(const PrimeCheckpointCache&) = delete;
+
+    size_t size() const { return count_; }
+    const CheckpointEntry& entry(size_t i) const { return entries_[i]; }
+
+    // Agrega entradas al final del archivo y vuelve a proyectarlo
+    // Appends entries to the file and maps it again
+    bool append(const std::vector<CheckpointEntry>& more) {
+#ifdef PRIME_CACHE_HAS_MMAP
+        if (more.empty()) return true;
+        const bool fresh = !valid_;
+        const size_t keep = sizeof(CheckpointHeader) + count_ * sizeof(CheckpointEntry);
+        unload();
+
+        int fd = open(path_.c_str(), O_WRONLY | O_CREAT | (fresh ? O_TRUNC : 0), 0644);
+        if (fd < 0) return false;
+        bool ok = true;
+        if (fresh) {
+            CheckpointHeader h;
+            std::memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+            h.block_size = block_size_;
+            ok = write_all(fd, &h, sizeof(h));
+        } else {
+            ok = ftruncate(fd, (off_t)keep) == 0 && lseek(fd, 0, SEEK_END) == (off_t)keep;
+        }
+        ok = ok && write_all(fd, more.data(), more.size() * sizeof(CheckpointEntry));
+        ok = (fsync(fd) == 0) && ok;
+        close(fd);
+
+        load();
+        return ok;
+#else
+        (void)more;
+        return false;
+#endif
+    }
+
+private:
+#ifdef PRIME_CACHE_HAS_MMAP
+    static bool write_all(int fd, const void* data, size_t len) {
+        const char* p = static_cast<const char*>(data);
+        while (len > 0) {
+            ssize_t w = write(fd, p, len);
+            if (w <= 0) return false;
+            p += w;
+            len -= (size_t)w;
+        }
+        return true;
+    }
+#endif
+
+    void load() {
+#ifdef PRIME_CACHE_HAS_MMAP
+        int fd = open(path_.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(CheckpointHeader)) {
+            void* m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (m != MAP_FAILED) {
+                map_ = m;
+                map_len_ = (size_t)st.st_size;
+                const CheckpointHeader* h = static_cast<const CheckpointHeader*>(m);
+                if (std::memcmp(h->magic, CHECKPOINT_MAGIC, sizeof(h->magic)) == 0 && h->block_size == block_size_) {
+                    valid_ = true;
+                    entries_ = reinterpret_cast<const CheckpointEntry*>(static_cast<const char*>(m) + sizeof(CheckpointHeader));
+                    count_ = (map_len_ - sizeof(CheckpointHeader)) / sizeof(CheckpointEntry);
+                }
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    void unload() {
+#ifdef PRIME_CACHE_HAS_MMAP
+        if (map_) munmap(map_, map_len_);
+#endif
+        map_ = nullptr;
+        map_len_ = 0;
+        entries_ = nullptr;
+        count_ = 0;
+        valid_ = false;
+    }
+
+    std::string path_;
+    long long block_size_;
+    void* map_ = nullptr;
+    size_t map_len_ = 0;
+    const CheckpointEntry* entries_ = nullptr;
+    size_t count_ = 0;
+    bool valid_ = false;
+};
+
+// Datos de cómo se resolvió una consulta con caché
+// How a cached query was answered
+struct CacheStats {
+    long long resumed_from = 0;  // límite cacheado desde el que se cribó / cached boundary sieving resumed from
+    size_t blocks_added = 0;     // bloques nuevos agregados al archivo / new blocks appended to the file
+};
+
+// Cuenta primos < N partiendo del punto de control más cercano por debajo
+// de N. Los bloques completos que falten se criban, se agregan al archivo y
+// solo el resto [k*block, N) se criba sin guardar.
+// Counts primes < N starting from the nearest checkpoint below N. Missing
+// full blocks are sieved and appended to the file, and only the remainder
+// [k*block, N) is sieved without being stored.
+static PrimeSummary count_primes_cached(long long N, int threads, const std::string& path, CacheStats& stats) {
+    PrimeSummary out;
+    stats = CacheStats();
+    if (N <= 2) return out;
+
+    const long long B = CHECKPOINT_BLOCK;
+    PrimeCheckpointCache cache(path, B);
+    const size_t k = (size_t)(N / B);
+    size_t have = std::min(k, cache.size());
+    stats.resumed_from = (long long)have * B;
+
+    if (k > have) {
+        std::vector<PrimeSummary> blocks;
+        count_primes_range((long long)have * B, (long long)k * B - 1, threads, SieveMode::Auto, B, &blocks);
+
+        CheckpointEntry prev{};
+        if (have > 0) prev = cache.entry(have - 1);
+        std::vector<CheckpointEntry> more;
+        more.reserve(blocks.size());
+        for (const PrimeSummary& blk : blocks) {
+            std::vector<long long> top;
+            for (long long p : prev.top10) if (p) top.push_back(p);
+            prepend_top10(top, blk.top10_desc);
+
+            CheckpointEntry e{};
+            e.count = prev.count + blk.total;
+            std::copy(top.begin(), top.end(), e.top10);
+            more.push_back(e);
+            prev = e;
+        }
+        if (cache.append(more)) {
+            stats.blocks_added = more.size();
+        }
+
+        // Aunque no se haya podido guardar, el resultado sigue siendo válido
+        // Even if it could not be stored, the result is still valid
+        PrimeSummary rest = count_primes_range((long long)k * B, N - 1, threads);
+        out.total = prev.count + rest.total;
+        out.top10_desc = rest.top10_desc;
+        for (long long p : prev.top10) if (p && out.top10_desc.size() < 10) out.top10_desc.push_back(p);
+        stats.resumed_from = (long long)have * B;
+        return out;
+    }
+
+    PrimeSummary rest = count_primes_range((long long)have * B, N - 1, threads);
+    out.total = rest.total;
+    out.top10_desc = rest.top10_desc;
+    if (have > 0) {
+        const CheckpointEntry& e = cache.entry(have - 1);
+        out.total += e.count;
+        for (long long p : e.top10) if (p && out.top10_desc.size() < 10) out.top10_desc.push_back(p);
+    }
+    return out;
+}
+
 // Imprime el top 10 de primos en orden descendente
 // Prints the top 10 primes in descending order
 static void print_top10(const std::vector<long long>& v) {
@@ -179,37 +815,79 @@ static void print_top10(const std::vector<long long>& v) {
     std::cout << '\n';
 }
 
-int main() {
+// Barrido de hilos y tamaños con el arnés común (--bench)
+// Thread and size sweep with the common harness (--bench)
+static int run_benchmark(const BenchArgs& args) {
+    BenchReport report("ej4");
+    for (long long N : args.get_list("sizes", {10000000LL, 100000000LL})) {
+        for (long long threads : args.threads()) {
+            report.run(args, "count_primes_parallel_dynamic", N, (int)threads, [&]() {
+                count_primes_parallel_dynamic(N, (int)threads);
+            });
+        }
+    }
+    report.print(args);
+    if (perf_regions_enabled()) perf_regions_report(std::cout);
+    return 0;
+}
+
+// Uso / Usage:
+//   ej4                               pregunta N / prompts for N
+//   ej4 --n 1e9 [--threads 8]         sin preguntas / non-interactive
+//   ej4 --bench [--sizes 1e7,1e8] [--threads 1,2,4] [--reps 5] [--format csv]
+//   --check compara además la criba por cubos con la clásica / also checks the bucket sieve against the classic one
+//   --perf agrega contadores de hardware por fase / adds per-phase hardware counters
+int main(int argc, char* argv[]) {
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
+    BenchArgs args(argc, argv);
+    if (args.has("perf")) perf_regions_enable();
+    if (args.has("bench")) return run_benchmark(args);
+
     long long N;
 
-    std::cout << "Ingrese N (>= 10000000): ";
-    // Prompt for N (>= 10,000,000)
-    if (!(std::cin >> N) || N < 2) {
+    if (args.has("n")) {
+        N = args.get_int("n", 0);
+    } else {
+        std::cout << "Ingrese N (>= 10000000): ";
+        // Prompt for N (>= 10,000,000)
+        if (!(std::cin >> N)) N = 0;
+    }
+    if (N < 2) {
         std::cerr << "Entrada inválida para N.\n";
         // Invalid input for N.
         return 1;
     }
 
-    // Usar todos los hilos disponibles del hardware
+    // Usar todos los hilos disponibles del hardware, salvo que se indique --threads
+    // Use every hardware thread unless --threads is given
     unsigned int hw = std::thread::hardware_concurrency();
-    int num_threads = hw ? static_cast<int>(hw) : 1;
-    std::cout << "N=" << N << "  hilos=" << num_threads << " (todos los disponibles)\n";
-
-    // Secuencial
-    // Sequential
-    auto t0 = Clock::now();
-    PrimeSummary seq = count_primes_sequential(N);
-    auto t1 = Clock::now();
-    double ms_seq = std::chrono::duration_cast<Ms>(t1 - t0).count();
-
-    std::cout << "\n[SECUENCIAL]\n";
-    std::cout << "Cantidad de primos < N: " << seq.total << "\n";
-    print_top10(seq.top10_desc);
-    std::cout << std::fixed << std::setprecision(3)
-              << "Tiempo secuencial: " << ms_seq/1000.0 << " s (" << ms_seq << " ms)\n";
+    int num_threads = (int)std::max(1LL, args.get_int("threads", hw ? (long long)hw : 1));
+    std::cout << "N=" << N << "  hilos=" << num_threads
+              << (args.has("threads") ? "\n" : " (todos los disponibles)\n");
+
+    // Secuencial (usa un byte por entero: se omite para N enormes)
+    // Sequential (one byte per integer: skipped for huge N)
+    const long long SEQUENTIAL_MAX_N = 4000000000LL;
+    const bool run_sequential = N <= SEQUENTIAL_MAX_N;
+    PrimeSummary seq;
+    double ms_seq = 0.0;
+    if (run_sequential) {
+        auto t0 = Clock::now();
+        seq = count_primes_sequential(N);
+        auto t1 = Clock::now();
+        ms_seq = std::chrono::duration_cast<Ms>(t1 - t0).count();
+
+        std::cout << "\n[SECUENCIAL]\n";
+        std::cout << "Cantidad de primos < N: " << seq.total << "\n";
+        print_top10(seq.top10_desc);
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Tiempo secuencial: " << ms_seq/1000.0 << " s (" << ms_seq << " ms)\n";
+    } else {
+        std::cout << "\n[SECUENCIAL] omitido: N > " << SEQUENTIAL_MAX_N << " no cabe en memoria\n";
+        // Skipped: the byte-per-integer sieve would not fit in memory.
+    }
 
     // Paralelo
     // Parallel
@@ -224,17 +902,71 @@ int main() {
     std::cout << std::fixed << std::setprecision(3)
               << "Tiempo multihilo: " << ms_par/1000.0 << " s (" << ms_par << " ms)\n";
 
-    if (seq.total != par.total) {
-        std::cout << "ADVERTENCIA: difiere la cantidad (seq=" << seq.total
-                  << ", par=" << par.total << ")\n";
-        // WARNING: counts differ between sequential and parallel.
+    // Con caché de puntos de control
+    // With checkpoint cache
+    CacheStats cache_stats;
+    auto t4 = Clock::now();
+    PrimeSummary cached = count_primes_cached(N, num_threads, "primos_cache.bin", cache_stats);
+    auto t5 = Clock::now();
+    double ms_cache = std::chrono::duration_cast<Ms>(t5 - t4).count();
+
+    std::cout << "\n[CACHÉ]\n";
+    std::cout << "Cantidad de primos < N: " << cached.total << "\n";
+    print_top10(cached.top10_desc);
+    std::cout << "Retomado desde " << cache_stats.resumed_from << ", bloques agregados: "
+              << cache_stats.blocks_added << "\n";
+    std::cout << std::fixed << std::setprecision(3)
+              << "Tiempo con caché: " << ms_cache/1000.0 << " s (" << ms_cache << " ms)\n";
+    if (cached.total != par.total || cached.top10_desc != par.top10_desc) {
+        std::cout << "ADVERTENCIA: la caché difiere del conteo multihilo\n";
+        // WARNING: cached result differs from the parallel count.
+    }
+
+    // Criba por cubos contra la clásica cruzando límites de reclamo (--check)
+    // Bucket sieve against the classic one across claim boundaries (--check)
+    if (args.has("check") && !bucket_matches_classic(N / 2)) {
+        std::cout << "ADVERTENCIA: la criba por cubos difiere de la clásica\n";
+        // WARNING: the bucket sieve differs from the classic one.
     }
-    if (ms_par > 0.0) {
-        double speedup = ms_seq / ms_par;
-        std::cout << "Speedup = " << std::setprecision(2) << std::fixed << speedup << "x\n";
-        // Speedup metric.
-        // Métrica de aceleración.
+
+    // Conteo combinatorio (Lucy_Hedgehog), sublineal
+    // Combinatorial (Lucy_Hedgehog) count, sublinear
+    auto t6 = Clock::now();
+    PrimeSummary lucy = count_primes_lucy(N, num_threads);
+    auto t7 = Clock::now();
+    double ms_lucy = std::chrono::duration_cast<Ms>(t7 - t6).count();
+
+    std::cout << "\n[LUCY_HEDGEHOG]\n";
+    std::cout << "Cantidad de primos < N: " << lucy.total << "\n";
+    print_top10(lucy.top10_desc);
+    std::cout << std::fixed << std::setprecision(3)
+              << "Tiempo Lucy_Hedgehog: " << ms_lucy/1000.0 << " s (" << ms_lucy << " ms)\n";
+    if (lucy.total != par.total || lucy.top10_desc != par.top10_desc) {
+        std::cout << "ADVERTENCIA: Lucy_Hedgehog difiere de la criba\n";
+        // WARNING: Lucy_Hedgehog differs from the sieve.
     }
 
+    if (run_sequential) {
+        if (seq.total != par.total) {
+            std::cout << "ADVERTENCIA: difiere la cantidad (seq=" << seq.total
+                      << ", par=" << par.total << ")\n";
+            // WARNING: counts differ between sequential and parallel.
+        }
+        if (seq.top10_desc != par.top10_desc) {
+            std::cout << "ADVERTENCIA: difieren los 10 primos más grandes entre secuencial y paralelo\n";
+            // WARNING: the 10 largest primes differ between sequential and parallel.
+        }
+        if (ms_par > 0.0) {
+            double speedup = ms_seq / ms_par;
+            std::cout << "Speedup = " << std::setprecision(2) << std::fixed << speedup << "x\n";
+            // Speedup metric.
+            // Métrica de aceleración.
+        }
+    }
+
+    // Contadores de hardware por fase (--perf)
+    // Hardware counters per phase (--perf)
+    if (perf_regions_enabled()) perf_regions_report(std::cout);
+
     return 0;
 }
@@ -0,0 +1,316 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Contadores de hardware por región con nombre, sin tener que enganchar perf
+// a mano. Cada hilo abre (la primera vez que entra a una región) un grupo de
+// perf_event_open con ciclos, instrucciones, fallos de L1D, fallos de LLC y
+// fallos de predicción de saltos, solo en espacio de usuario. PerfScope lee
+// el grupo al entrar y al salir y suma la diferencia en la región, por hilo.
+// Si perf_event_open no está disponible (otro sistema, perf_event_paranoid,
+// máquina virtual sin PMU) se mide solo el tiempo de pared.
+// Las regiones están apagadas hasta llamar a perf_regions_enable(): apagadas,
+// un PerfScope cuesta una lectura atómica.
+// Hardware counters per named region, without attaching perf by hand. Each
+// thread opens (the first time it enters a region) a perf_event_open group
+// with cycles, instructions, L1D misses, LLC misses and branch misses, user
+// space only. PerfScope reads the group on entry and exit and adds the
+// difference to the region, per thread. If perf_event_open is unavailable
+// (other OS, perf_event_paranoid, VM without a PMU) only wall-clock time is
+// recorded.
+// Regions are off until perf_regions_enable() is called: when off, a
+// PerfScope costs one atomic load.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#define PERF_COUNTERS_HAS_PERF_EVENT 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+struct PerfTotals {
+    uint64_t calls = 0;
+    double seconds = 0;
+    uint64_t values[PERF_COUNTER_COUNT] = {};
+    bool has[PERF_COUNTER_COUNT] = {};
+};
+
+namespace perf_detail {
+
+inline std::atomic<bool>& enabled_flag() {
+    static std::atomic<bool> enabled(false);
+    return enabled;
+}
+
+// Número de hilo estable para el reporte / stable thread number for the report
+inline int thread_ordinal() {
+    static std::atomic<int> next(0);
+    thread_local int id = next.fetch_add(1);
+    return id;
+}
+
+// Grupo de contadores del hilo actual
+// Counter group of the current thread
+class ThreadCounters {
+public:
+    ThreadCounters() {
+#ifdef PERF_COUNTERS_HAS_PERF_EVENT
+        const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D |
+                                       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const struct { uint32_t type; uint64_t config; } events[PERF_COUNTER_COUNT] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, l1d_read_miss},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        };
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+            perf_event_attr attr{};
+            attr.size = sizeof attr;
+            attr.type = events[c].type;
+            attr.config = events[c].config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.disabled = leader < 0 ? 1 : 0;
+            int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+            if (fd < 0) {
+                if (leader < 0) return;   // sin ciclos no hay grupo / no cycles, no group
+                continue;
+            }
+            if (leader < 0) leader = fd;
+            else fds[count] = fd;
+            slot[count++] = c;
+        }
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    ~ThreadCounters() {
+#ifdef PERF_COUNTERS_HAS_PERF_EVENT
+        for (int i = 1; i < count; i++) close(fds[i]);
+        if (leader >= 0) close(leader);
+#endif
+    }
+
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+    bool available() const { return leader >= 0; }
+
+    // Lectura cruda del grupo: cuentas sin escalar más los tiempos enabled y
+    // running del kernel. Escalar cada lectura por separado con su propio
+    // factor puede dar un final menor que el inicio; por eso se escala la
+    // diferencia (ver PerfScope).
+    // Raw group read: unscaled counts plus the kernel's enabled and running
+    // times. Scaling every read on its own with its own factor can give an
+    // end below the start; hence the difference is scaled (see PerfScope).
+    struct Sample {
+        uint64_t values[PERF_COUNTER_COUNT] = {};
+        uint64_t enabled = 0;
+        uint64_t running = 0;
+    };
+
+    bool read(Sample& out) const {
+#ifdef PERF_COUNTERS_HAS_PERF_EVENT
+        if (leader < 0) return false;
+        uint64_t buf[3 + PERF_COUNTER_COUNT];
+        if (::read(leader, buf, sizeof buf) < (ssize_t)(3 * sizeof(uint64_t))) return false;
+        uint64_t nr = buf[0];
+        out.enabled = buf[1];
+        out.running = buf[2];
+        for (uint64_t i = 0; i < nr && i < (uint64_t)count; i++)
+            out.values[slot[i]] = buf[3 + i];
+        return true;
+#else
+        (void)out;
+        return false;
+#endif
+    }
+
+    bool has(int counter) const {
+        for (int i = 0; i < count; i++)
+            if (slot[i] == counter) return true;
+        return false;
+    }
+
+private:
+    int leader = -1;
+    int fds[PERF_COUNTER_COUNT] = {-1, -1, -1, -1, -1};
+    int slot[PERF_COUNTER_COUNT] = {};
+    int count = 0;
+};
+
+inline ThreadCounters& thread_counters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+// Totales por (región, hilo) / totals per (region, thread)
+struct Registry {
+    std::mutex m;
+    std::map<std::pair<std::string, int>, PerfTotals> totals;
+};
+
+inline Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+} // namespace perf_detail
+
+inline void perf_regions_enable(bool on = true) { perf_detail::enabled_flag().store(on); }
+inline bool perf_regions_enabled() { return perf_detail::enabled_flag().load(std::memory_order_relaxed); }
+
+inline void perf_regions_reset() {
+    auto& r = perf_detail::registry();
+    std::lock_guard<std::mutex> lock(r.m);
+    r.totals.clear();
+}
+
+// Mide el bloque donde vive bajo el nombre dado (debe ser un literal o
+// sobrevivir al scope)
+// Measures the enclosing block under the given name (must be a literal or
+// outlive the scope)
+class PerfScope {
+public:
+    explicit PerfScope(const char* name) : name(name) {
+        if (!perf_regions_enabled()) {
+            this->name = nullptr;
+            return;
+        }
+        counters = &perf_detail::thread_counters();
+        has_counters = counters->read(begin);
+        start = std::chrono::steady_clock::now();
+    }
+
+    ~PerfScope() {
+        if (!name) return;
+        auto end = std::chrono::steady_clock::now();
+        perf_detail::ThreadCounters::Sample sample;
+        bool ok = has_counters && counters->read(sample);
+
+        auto& r = perf_detail::registry();
+        std::lock_guard<std::mutex> lock(r.m);
+        PerfTotals& t = r.totals[{name, perf_detail::thread_ordinal()}];
+        t.calls++;
+        t.seconds += std::chrono::duration<double>(end - start).count();
+        if (ok) {
+            // Con multiplexado el grupo contó solo una parte del intervalo:
+            // se extrapola con enabled / running de ese mismo intervalo
+            // Under multiplexing the group counted only part of the interval:
+            // extrapolate with enabled / running of that same interval
+            uint64_t enabled = sample.enabled - begin.enabled;
+            uint64_t running = sample.running - begin.running;
+            double scale = (running > 0 && running < enabled) ? (double)enabled / (double)running : 1.0;
+            for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+                if (!counters->has(c)) continue;
+                uint64_t delta = sample.values[c] >= begin.values[c] ? sample.values[c] - begin.values[c] : 0;
+                t.values[c] += (uint64_t)((double)delta * scale);
+                t.has[c] = true;
+            }
+        }
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    const char* name;
+    perf_detail::ThreadCounters* counters = nullptr;
+    bool has_counters = false;
+    perf_detail::ThreadCounters::Sample begin;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Tabla por región (suma de hilos) y, si per_thread, una fila por hilo.
+// Por hilo, los segundos son tiempo dentro de la región; en el total se
+// suman los de todos los hilos.
+// Table per region (summed over threads) and, if per_thread, one row per
+// thread. Seconds are time spent inside the region, summed over threads.
+inline void perf_regions_report(std::ostream& os, bool per_thread = true) {
+    auto& r = perf_detail::registry();
+    std::lock_guard<std::mutex> lock(r.m);
+    if (r.totals.empty()) return;
+
+    std::map<std::string, PerfTotals> regions;
+    std::map<std::string, int> threads;
+    for (const auto& e : r.totals) {
+        PerfTotals& t = regions[e.first.first];
+        threads[e.first.first]++;
+        t.calls += e.second.calls;
+        t.seconds += e.second.seconds;
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+            t.values[c] += e.second.values[c];
+            t.has[c] = t.has[c] || e.second.has[c];
+        }
+    }
+
+    const std::ios_base::fmtflags saved_flags = os.flags();
+    const std::streamsize saved_precision = os.precision();
+    bool any_counters = false;
+    for (const auto& e : regions)
+        any_counters = any_counters || e.second.has[PERF_CYCLES];
+
+    auto value = [&](const PerfTotals& t, int c) -> std::string {
+        return t.has[c] ? std::to_string(t.values[c]) : std::string("-");
+    };
+    auto row = [&](const std::string& label, const PerfTotals& t, int nthreads) {
+        os << std::left << std::setw(34) << label << std::right << std::setw(9) << t.calls
+           << std::setw(7) << nthreads << std::fixed << std::setprecision(4) << std::setw(11) << t.seconds;
+        if (any_counters) {
+            double ipc = (t.has[PERF_INSTRUCTIONS] && t.values[PERF_CYCLES] > 0)
+                ? (double)t.values[PERF_INSTRUCTIONS] / (double)t.values[PERF_CYCLES] : 0.0;
+            os << std::setw(16) << value(t, PERF_CYCLES) << std::setw(16) << value(t, PERF_INSTRUCTIONS)
+               << std::setprecision(2) << std::setw(7) << ipc
+               << std::setw(14) << value(t, PERF_L1D_MISSES) << std::setw(13) << value(t, PERF_LLC_MISSES)
+               << std::setw(13) << value(t, PERF_BRANCH_MISSES);
+        }
+        os << "\n";
+    };
+
+    os << "\n=== CONTADORES POR REGIÓN"
+       << (any_counters ? "" : " (perf_event_open no disponible: solo tiempo)") << " ===\n";
+    os << std::left << std::setw(34) << "region" << std::right << std::setw(9) << "llamadas"
+       << std::setw(7) << "hilos" << std::setw(11) << "seg";
+    if (any_counters) {
+        os << std::setw(16) << "ciclos" << std::setw(16) << "instr" << std::setw(7) << "IPC"
+           << std::setw(14) << "L1D miss" << std::setw(13) << "LLC miss" << std::setw(13) << "br miss";
+    }
+    os << "\n";
+
+    for (const auto& e : regions) {
+        row(e.first, e.second, threads[e.first]);
+        if (!per_thread || threads[e.first] < 2) continue;
+        for (const auto& t : r.totals) {
+            if (t.first.first != e.first) continue;
+            row("  hilo " + std::to_string(t.first.second), t.second, 1);
+        }
+    }
+    os.flags(saved_flags);
+    os.precision(saved_precision);
+}
+
+#endif
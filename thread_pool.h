@@ -0,0 +1,420 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Pool persistente con robo de trabajo compartido por ej1-ej4.
+// Crear y unir std::thread en cada llamada cuesta decenas de microsegundos por
+// hilo; con trabajos chicos y repetidos ese costo domina. Acá los hilos se
+// crean una vez y duermen entre rondas.
+//  - Cada participante tiene una cola (deque) propia: saca del final de la
+//    suya y roba del principio de las ajenas.
+//  - El hilo que llama a run() también trabaja (participante 0), así un pool
+//    de tamaño P tiene P - 1 hilos propios y con P = 1 todo corre en línea.
+//  - Opcionalmente cada trabajador se fija a una CPU; el orden de CPUs puede
+//    ser compacto o repartido entre nodos NUMA. Con trabajadores fijos, la
+//    memoria que inicializan en parallel_for queda en su nodo (first touch).
+// Persistent work-stealing pool shared by ej1-ej4.
+// Creating and joining std::threads on every call costs tens of microseconds
+// per thread; with small repeated jobs that cost dominates. Here threads are
+// created once and sleep between rounds.
+//  - Every participant owns a deque: it pops from its back and steals from
+//    the front of the others.
+//  - The thread calling run() also works (participant 0), so a pool of size
+//    P owns P - 1 threads and with P = 1 everything runs inline.
+//  - Optionally each worker is pinned to a CPU; the CPU order can be compact
+//    or spread across NUMA nodes. With pinned workers, memory they initialise
+//    inside parallel_for stays on their node (first touch).
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cache_padded.h"
+
+#if defined(__linux__)
+#define THREAD_POOL_HAS_AFFINITY 1
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Dónde se ubican los trabajadores
+// Where workers are placed
+enum class Placement {
+    None,       // sin fijar, decide el sistema / unpinned, the OS decides
+    Compact,    // CPUs en orden numérico / CPUs in numeric order
+    Scatter     // alternando entre nodos NUMA / alternating across NUMA nodes
+};
+
+// Ubicación por defecto tomada de la variable de entorno POOL_PLACEMENT
+// ("compact" o "scatter"); sin ella los hilos no se fijan
+// Default placement taken from the POOL_PLACEMENT environment variable
+// ("compact" or "scatter"); without it threads are not pinned
+inline Placement default_placement() {
+    const char* env = std::getenv("POOL_PLACEMENT");
+    if (env && std::strcmp(env, "compact") == 0) return Placement::Compact;
+    if (env && std::strcmp(env, "scatter") == 0) return Placement::Scatter;
+    return Placement::None;
+}
+
+namespace pool_detail {
+
+#ifdef THREAD_POOL_HAS_AFFINITY
+// Lee una lista de CPUs del estilo "0-3,8,10-11"
+// Parses a CPU list like "0-3,8,10-11"
+inline std::vector<int> parse_cpu_list(const char* path) {
+    std::vector<int> cpus;
+    FILE* f = std::fopen(path, "r");
+    if (!f) return cpus;
+    int a, b;
+    while (std::fscanf(f, "%d", &a) == 1) {
+        b = a;
+        int c = std::fgetc(f);
+        if (c == '-') {
+            if (std::fscanf(f, "%d", &b) != 1) break;
+            c = std::fgetc(f);
+        }
+        for (int cpu = a; cpu <= b; cpu++) cpus.push_back(cpu);
+        if (c != ',') break;
+    }
+    std::fclose(f);
+    return cpus;
+}
+
+// CPUs permitidas para el proceso, ordenadas según la ubicación pedida
+// CPUs allowed for the process, ordered according to the requested placement
+inline std::vector<int> cpu_order(Placement placement) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof allowed, &allowed) != 0) return {};
+
+    std::vector<std::vector<int>> nodes;
+    if (placement == Placement::Scatter) {
+        for (int node = 0;; node++) {
+            char path[96];
+            std::snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist", node);
+            std::vector<int> cpus = parse_cpu_list(path);
+            if (cpus.empty()) break;
+            nodes.push_back(std::move(cpus));
+        }
+    }
+    if (nodes.empty()) {
+        nodes.emplace_back();
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) nodes[0].push_back(cpu);
+    }
+
+    for (auto& node : nodes) {
+        node.erase(std::remove_if(node.begin(), node.end(),
+                                  [&](int cpu) { return !CPU_ISSET(cpu, &allowed); }),
+                   node.end());
+    }
+
+    // Una CPU de cada nodo por vuelta (con un solo nodo queda orden compacto)
+    // One CPU from each node per round (with a single node this is compact)
+    std::vector<int> order;
+    for (size_t i = 0;; i++) {
+        bool any = false;
+        for (const auto& node : nodes) {
+            if (i < node.size()) {
+                order.push_back(node[i]);
+                any = true;
+            }
+        }
+        if (!any) break;
+    }
+    return order;
+}
+#endif
+
+} // namespace pool_detail
+
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int numThreads, Placement placement = default_placement())
+        : queues(std::max(1, numThreads)) {
+#ifdef THREAD_POOL_HAS_AFFINITY
+        std::vector<int> cpus;
+        if (placement != Placement::None) cpus = pool_detail::cpu_order(placement);
+#else
+        (void)placement;
+#endif
+        for (int w = 1; w < size(); w++) {
+            workers.emplace_back(&WorkStealingPool::workerLoop, this, w);
+#ifdef THREAD_POOL_HAS_AFFINITY
+            if (!cpus.empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                // Los trabajadores empiezan en 1: w - 1 usa cpus[0] y no repite
+                // CPU hasta tener más trabajadores que CPUs
+                // Workers start at 1: w - 1 uses cpus[0] and does not repeat a
+                // CPU until there are more workers than CPUs
+                CPU_SET(cpus[(size_t)(w - 1) % cpus.size()], &set);
+                pthread_setaffinity_np(workers.back().native_handle(), sizeof set, &set);
+            }
+#endif
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& th : workers) th.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Participantes, incluido el hilo que llama a run()
+    // Participants, including the thread calling run()
+    int size() const { return (int)queues.size(); }
+
+    // Ejecuta task(t) para t en [0, numTasks) y espera a que terminen todas.
+    // Las tareas se reparten inicialmente en rangos contiguos por participante.
+    // Si alguna tarea lanza, las demás igual se ejecutan y run() relanza la
+    // primera excepción al terminar la ronda.
+    // No es reentrante: una tarea no puede llamar a run() del mismo pool.
+    // Runs task(t) for t in [0, numTasks) and waits for all of them.
+    // Tasks are initially split in contiguous ranges per participant.
+    // If a task throws, the rest still run and run() rethrows the first
+    // exception once the round is over.
+    // Not reentrant: a task must not call run() on the same pool.
+    void run(int numTasks, const std::function<void(int)>& task) {
+        if (numTasks <= 0) return;
+        int P = size();
+        if (P == 1 || numTasks == 1) {
+            for (int t = 0; t < numTasks; t++) task(t);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            for (int w = 0; w < P; w++) {
+                std::lock_guard<std::mutex> queueLock(queues[w]->m);
+                int begin = (int)((long long)numTasks * w / P);
+                int end = (int)((long long)numTasks * (w + 1) / P);
+                for (int t = begin; t < end; t++)
+                    queues[w]->tasks.push_back({&task, t});
+            }
+            remaining = numTasks;
+            generation++;
+        }
+        wake.notify_all();
+
+        finish(drain(0));
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        done.wait(lock, [&] { return remaining == 0; });
+        if (error) {
+            std::exception_ptr first;
+            first.swap(error);
+            lock.unlock();
+            std::rethrow_exception(first);
+        }
+    }
+
+    // Pool compartido del proceso con numThreads participantes. Si se pide
+    // otro tamaño se reemplaza, lo que invalida referencias anteriores; debe
+    // llamarse desde un solo hilo (normalmente main).
+    // Process-wide pool with numThreads participants. Asking for another size
+    // replaces it, invalidating earlier references; call it from a single
+    // thread (normally main).
+    static WorkStealingPool& shared(int numThreads, Placement placement = default_placement()) {
+        static std::unique_ptr<WorkStealingPool> instance;
+        static Placement current = Placement::None;
+        numThreads = std::max(1, numThreads);
+        if (!instance || instance->size() != numThreads || current != placement) {
+            instance.reset();
+            instance.reset(new WorkStealingPool(numThreads, placement));
+            current = placement;
+        }
+        return *instance;
+    }
+
+private:
+    // Cada entrada lleva su función: un hilo que despierta tarde nunca
+    // ejecuta una tarea nueva con la función de una ronda anterior
+    // Every entry carries its function: a thread waking up late never runs
+    // a new task with the function of an earlier round
+    struct Task {
+        const std::function<void(int)>* fn;
+        int index;
+    };
+
+    struct Queue {
+        std::deque<Task> tasks;
+        std::mutex m;
+    };
+
+    bool popLocal(int w, Task& out) {
+        Queue& q = *queues[w];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.tasks.empty()) return false;
+        out = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int w, Task& out) {
+        int P = size();
+        for (int i = 1; i < P; i++) {
+            Queue& victim = *queues[(w + i) % P];
+            std::lock_guard<std::mutex> lock(victim.m);
+            if (victim.tasks.empty()) continue;
+            out = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    // Ejecuta tareas hasta que no quede ninguna visible; devuelve cuántas.
+    // Una tarea que lanza cuenta como terminada: si la excepción saliera de
+    // acá, remaining nunca llegaría a 0 y run() esperaría para siempre.
+    // Runs tasks until none is visible; returns how many.
+    // A throwing task counts as finished: if the exception escaped here,
+    // remaining would never reach 0 and run() would wait forever.
+    int drain(int w) {
+        Task task;
+        int finished = 0;
+        while (popLocal(w, task) || steal(w, task)) {
+            try {
+                (*task.fn)(task.index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (!error) error = std::current_exception();
+            }
+            finished++;
+        }
+        return finished;
+    }
+
+    void finish(int finished) {
+        if (finished == 0) return;
+        std::lock_guard<std::mutex> lock(stateMutex);
+        remaining -= finished;
+        if (remaining == 0) done.notify_all();
+    }
+
+    void workerLoop(int w) {
+        unsigned long long seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            finish(drain(w));
+        }
+    }
+
+    // Cada cola en su propia línea para que los mutex no compartan línea
+    // Each queue on its own line so the mutexes do not share a line
+    std::vector<CachePadded<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned long long generation = 0;
+    int remaining = 0;
+    std::exception_ptr error;  // primera excepción de la ronda / first exception of the round
+    bool stopping = false;
+};
+
+// Recorre [begin, end) en trozos de al menos grain elementos y llama
+// fn(lo, hi) para cada uno. Se generan hasta 4 trozos por participante para
+// que el robo de trabajo compense trozos desparejos.
+// Walks [begin, end) in chunks of at least grain elements calling fn(lo, hi)
+// on each. Up to 4 chunks per participant are created so work stealing can
+// even out uneven chunks.
+template <typename Index, typename Fn>
+void parallel_for(WorkStealingPool& pool, Index begin, Index end, Index grain, Fn&& fn) {
+    if (end <= begin) return;
+    long long total = (long long)(end - begin);
+    long long minChunk = std::max<long long>(1, (long long)grain);
+    long long chunks = std::min<long long>(4LL * pool.size(), (total + minChunk - 1) / minChunk);
+    chunks = std::max<long long>(1, chunks);
+    if (chunks == 1) {
+        fn(begin, end);
+        return;
+    }
+    std::function<void(int)> task = [&](int c) {
+        Index lo = begin + (Index)(total * c / chunks);
+        Index hi = begin + (Index)(total * (c + 1) / chunks);
+        fn(lo, hi);
+    };
+    pool.run((int)chunks, task);
+}
+
+// Reducción sobre [begin, end): map(lo, hi) devuelve el parcial de un trozo y
+// combine los junta en orden de trozo, así el resultado no depende de qué
+// hilo ejecutó cada trozo (solo de pool.size() y grain).
+// Reduction over [begin, end): map(lo, hi) returns a chunk's partial and
+// combine merges them in chunk order, so the result does not depend on which
+// thread ran each chunk (only on pool.size() and grain).
+template <typename T, typename Index, typename Map, typename Combine>
+T parallel_reduce(WorkStealingPool& pool, Index begin, Index end, Index grain,
+                  T identity, Map&& map, Combine&& combine) {
+    if (end <= begin) return identity;
+    long long total = (long long)(end - begin);
+    long long minChunk = std::max<long long>(1, (long long)grain);
+    long long chunks = std::min<long long>(4LL * pool.size(), (total + minChunk - 1) / minChunk);
+    chunks = std::max<long long>(1, chunks);
+
+    std::vector<CachePadded<T>> partial((size_t)chunks, CachePadded<T>(identity));
+    std::function<void(int)> task = [&](int c) {
+        Index lo = begin + (Index)(total * c / chunks);
+        Index hi = begin + (Index)(total * (c + 1) / chunks);
+        *partial[(size_t)c] = map(lo, hi);
+    };
+    pool.run((int)chunks, task);
+
+    T result = identity;
+    for (const auto& p : partial) result = combine(result, *p);
+    return result;
+}
+
+// Ordena [first, last) con comp: cada participante ordena un trozo con
+// std::sort y luego los trozos se mezclan de a pares (inplace_merge) en
+// rondas paralelas. Por debajo de 2 * grain elementos ordena en línea.
+// Sorts [first, last) with comp: each participant sorts one chunk with
+// std::sort and then chunks are merged pairwise (inplace_merge) in parallel
+// rounds. Below 2 * grain elements it sorts inline.
+template <typename It, typename Comp>
+void parallel_sort(WorkStealingPool& pool, It first, It last, Comp comp, size_t grain = 1 << 16) {
+    const size_t n = (size_t)(last - first);
+    const size_t parts = std::min<size_t>((size_t)pool.size(), n / std::max<size_t>(1, grain));
+    if (parts <= 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<size_t> bounds(parts + 1);
+    for (size_t p = 0; p <= parts; p++) bounds[p] = n * p / parts;
+    pool.run((int)parts, [&](int p) {
+        std::sort(first + bounds[p], first + bounds[p + 1], comp);
+    });
+
+    while (bounds.size() > 2) {
+        const size_t merges = (bounds.size() - 1) / 2;
+        pool.run((int)merges, [&](int m) {
+            std::inplace_merge(first + bounds[2 * m], first + bounds[2 * m + 1],
+                               first + bounds[2 * m + 2], comp);
+        });
+        std::vector<size_t> merged;
+        for (size_t b = 0; b < bounds.size(); b += 2) merged.push_back(bounds[b]);
+        if (merged.back() != n) merged.push_back(n);
+        bounds.swap(merged);
+    }
+}
+
+#endif